@@ -1,4 +1,40 @@
 #include "ajson.hpp"
+#include "ajson_internal.hpp"
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define AJSON_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define AJSON_SSE2
+#endif
+
+#if defined(__AVX2__) || defined(AJSON_SSE2)
+#define AJSON_SIMD
+#endif
+
+#if defined(__AVX2__) || defined(__PCLMUL__)
+#include <immintrin.h>
+#elif defined(AJSON_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace ajson {
 	const static char BackspaceCharacter = 0x08;
@@ -13,12 +49,12 @@ namespace ajson {
 		return n;
 	}
 
-	static std::string GetLine(const char* s, int line, uint32_t* pBeggining = nullptr) {
+	static std::string GetLine(const char* s, uint32_t length, int line, uint32_t* pBeggining = nullptr) {
 		uint32_t n = 0;
 		uint32_t lineStart = 0, lineEnd = 0;
 		bool started = false;
 
-		for(uint32_t i = 0;i < strlen(s);i++) {
+		for(uint32_t i = 0;i < length;i++) {
 			if(n == line && !started) {
 				lineStart = i;
 				started = true;
@@ -36,7 +72,7 @@ namespace ajson {
 		}
 
 		if(lineEnd == 0)
-			lineEnd = strlen(s);
+			lineEnd = length;
 
 		if(lineStart == 0 && lineEnd == 0) {
 			return std::string("");
@@ -63,6 +99,9 @@ namespace ajson {
 	    } else if((c & 0xf8) == 0xf0) {
 	        return 4;
 	    }
+
+	    // Continuation or invalid byte
+	    return 1;
 	}
 
 	static std::string MakePointerLine(const std::string& s, uint32_t pointerPosition) {
@@ -91,70 +130,174 @@ namespace ajson {
 		return ss.str();
 	}
 
-	static std::string EscapeString(const std::string& s) {
-		std::ostringstream ss;
+	static inline uint32_t HexValue(char c) {
+		if(c >= '0' && c <= '9') {
+			return c - '0';
+		} else if(c >= 'a' && c <= 'f') {
+			return c - 'a' + 10;
+		} else {
+			return c - 'A' + 10;
+		}
+	}
 
-		for(int i = 0;i << s.size();) {
-			if(s[i] != '\\') {
-				ss << s[i];
-				i++;
-			} else {
-				if(s[i + 1] == '\n') {
-					ss << '\n';
-					i += 2;
-				} else if(s[i + 1] == '\t') {
-					ss << '\t';
-					i += 2;
-				} else if(s[i + 1] == '\r') {
-					i += 2;
-				} else if(s[i + 1] == '"') {
-					ss << '"';
-					i += 2;
-				} else if(s[i + 1] == '/') {
-					ss << '/';
-					i += 2;
-				} else if(s[i + 1] == '\\') {
-					ss << '\\';
-					i += 2;
-				} else if(s[i + 1] == 'b') {
-					ss << BackspaceCharacter;
-					i += 2;
+	static inline uint32_t ReadHex4(const char* data) {
+		return (HexValue(data[0]) << 12) | (HexValue(data[1]) << 8) | (HexValue(data[2]) << 4) | HexValue(data[3]);
+	}
+
+	/**
+	 * Writes a code point as UTF-8, returns the number of bytes written.
+	 */
+	static inline uint32_t WriteUtf8(uint32_t codePoint, char* out) {
+		if(codePoint < 0x80) {
+			out[0] = static_cast<char>(codePoint);
+			return 1;
+		} else if(codePoint < 0x800) {
+			out[0] = static_cast<char>(0xc0 | (codePoint >> 6));
+			out[1] = static_cast<char>(0x80 | (codePoint & 0x3f));
+			return 2;
+		} else if(codePoint < 0x10000) {
+			out[0] = static_cast<char>(0xe0 | (codePoint >> 12));
+			out[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+			out[2] = static_cast<char>(0x80 | (codePoint & 0x3f));
+			return 3;
+		} else {
+			out[0] = static_cast<char>(0xf0 | (codePoint >> 18));
+			out[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+			out[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+			out[3] = static_cast<char>(0x80 | (codePoint & 0x3f));
+			return 4;
+		}
+	}
+
+	/**
+	 * Decodes the escape sequences of a json string, given without quotes and already validated by the tokenizer, into 'out'.
+	 * \u escapes become UTF-8, surrogate pairs are combined and lone surrogates become U+FFFD.
+	 * Runs between escapes are copied in bulk. Decoding never makes a string longer, so 'out' is sized once.
+	 */
+	static void EscapeString(const char* data, uint32_t size, std::string& out) {
+		const char* end = data + size;
+		const char* backslash = static_cast<const char*>(memchr(data, '\\', size));
+
+		if(backslash == nullptr) {
+			out.assign(data, size);
+			return;
+		}
+
+		out.resize(size);
+		char* begin = &out[0];
+		char* write = begin;
+
+		while(backslash != nullptr) {
+			memcpy(write, data, backslash - data);
+			write += backslash - data;
+			data = backslash + 2;
+
+			switch(backslash[1]) {
+			case 'b':
+				*write++ = BackspaceCharacter;
+				break;
+			case 'f':
+				*write++ = '\f';
+				break;
+			case 'n':
+				*write++ = '\n';
+				break;
+			case 'r':
+				*write++ = '\r';
+				break;
+			case 't':
+				*write++ = '\t';
+				break;
+			case 'u': {
+				uint32_t codePoint = ReadHex4(data);
+				data += 4;
+
+				if(codePoint >= 0xd800 && codePoint <= 0xdbff) {
+					// High surrogate, has to be followed by a low one
+					uint32_t low = 0;
+					if(end - data >= 6 && data[0] == '\\' && data[1] == 'u') {
+						low = ReadHex4(&data[2]);
+					}
+
+					if(low >= 0xdc00 && low <= 0xdfff) {
+						codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+						data += 6;
+					} else {
+						codePoint = 0xfffd;
+					}
+				} else if(codePoint >= 0xdc00 && codePoint <= 0xdfff) {
+					codePoint = 0xfffd;
 				}
+
+				write += WriteUtf8(codePoint, write);
+				break;
+			}
+			default:
+				// '"', '\\' and '/'
+				*write++ = backslash[1];
+				break;
 			}
+
+			backslash = static_cast<const char*>(memchr(data, '\\', end - data));
 		}
 
-		return ss.str();
+		memcpy(write, data, end - data);
+		write += end - data;
+		out.resize(write - begin);
 	}
 
-	static std::string DescapeString(const std::string& s) {
-		std::ostringstream ss;
+	/**
+	 * Appends 's' to 'buf' as json string contents, escaping '"', '\\' and all control characters.
+	 */
+	static void DescapeString(const std::string& s, std::string& buf) {
+		const char* data = s.data();
+		size_t size = s.size();
+		size_t run = 0;
+
+		for(size_t i = 0;i < size;i++) {
+			uint8_t c = data[i];
+			if(c >= 0x20 && c != '"' && c != '\\') {
+				continue;
+			}
 
-		for(int i = 0;i < s.size();) {
-			if(s[i] == '\n') {
-				ss << "\\n";
-				i++;
-			} else if(s[i] == '\t') {
-				ss << "\\t";
-				i++;
-			} else if(s[i] == '"') {
-				ss << "\\\"";
-				i++;
-			} else if(s[i] == '\\') {
-				ss << "\\\\";
-				i++;
-			} else if(s[i] == BackspaceCharacter) {
-				ss << "\\b";
-				i++;
-			} else {
-				ss << s[i];
-				i++;
+			buf.append(&data[run], i - run);
+			run = i + 1;
+
+			switch(c) {
+			case '"':
+				buf += "\\\"";
+				break;
+			case '\\':
+				buf += "\\\\";
+				break;
+			case BackspaceCharacter:
+				buf += "\\b";
+				break;
+			case '\f':
+				buf += "\\f";
+				break;
+			case '\n':
+				buf += "\\n";
+				break;
+			case '\r':
+				buf += "\\r";
+				break;
+			case '\t':
+				buf += "\\t";
+				break;
+			default: {
+				const char* hex = "0123456789abcdef";
+				char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+				buf.append(escape, 6);
+				break;
+			}
 			}
 		}
 
-		return ss.str();
+		buf.append(&data[run], size - run);
 	}
 
-	static void ParseBlobString(char* parseBuffer, uint32_t length, std::vector<uint8_t>& blob) {
+	static void ParseBlobString(const char* parseBuffer, uint32_t length, std::vector<uint8_t>& blob) {
 		blob.resize(0);
 
 		// Blob strings should be checked before for correctness, so no need to do it here
@@ -249,13 +392,13 @@ namespace ajson {
 		return ss.str();
 	}
 
-	static std::string ComposeErrorMsg(const char* buffer, const std::string& msg, uint32_t tokenLocation) {
+	static std::string ComposeErrorMsg(const char* buffer, uint32_t length, const std::string& msg, uint32_t tokenLocation) {
 		std::ostringstream stream;
 
 		int lineNum = GetLineNum(buffer, tokenLocation);
 
 		uint32_t lineBeggining = 0;
-		std::string errorLine = GetLine(buffer, lineNum, &lineBeggining);
+		std::string errorLine = GetLine(buffer, length, lineNum, &lineBeggining);
 		std::string pointerLine = MakePointerLine(errorLine, tokenLocation - lineBeggining);
 
 		stream << "At line [";
@@ -265,13 +408,13 @@ namespace ajson {
 		return stream.str();
 	}
 
-	static std::string ComposeUnexpectedTokenMsg(const char* buffer, uint32_t tokenLocation) {
+	static std::string ComposeUnexpectedTokenMsg(const char* buffer, uint32_t length, uint32_t tokenLocation) {
 		std::ostringstream stream;
 
 		int lineNum = GetLineNum(buffer, tokenLocation);
 
 		uint32_t lineBeggining = 0;
-		std::string errorLine = GetLine(buffer, lineNum, &lineBeggining);
+		std::string errorLine = GetLine(buffer, length, lineNum, &lineBeggining);
 		std::string pointerLine = MakePointerLine(errorLine, tokenLocation - lineBeggining);
 
 		stream << "At line [";
@@ -282,6 +425,35 @@ namespace ajson {
 		return stream.str();
 	}
 
+	/**
+	 * Moves the "At line [line:column]" of an error composed on a window of the input, 'lines' is the number of lines
+	 * before the window and 'column' the column it starts at, which only applies to the first line of the window.
+	 */
+	static std::string ShiftErrorLocation(const std::string& msg, uint64_t lines, uint64_t column) {
+		static const char Prefix[] = "At line [";
+		if(msg.compare(0, sizeof(Prefix) - 1, Prefix) != 0) {
+			return msg;
+		}
+
+		char* end;
+		uint64_t line = strtoull(msg.c_str() + sizeof(Prefix) - 1, &end, 10);
+		if(*end != ':') {
+			return msg;
+		}
+		uint64_t lineColumn = strtoull(end + 1, &end, 10);
+		if(*end != ']') {
+			return msg;
+		}
+
+		if(line == 1) {
+			lineColumn += column;
+		}
+
+		std::ostringstream stream;
+		stream << Prefix << (line + lines) << ':' << lineColumn << end;
+		return stream.str();
+	}
+
 	static std::string ComposeBinaryError(const char* buffer, uint32_t offset) {
 		std::ostringstream ss;
 		ss << "At byte " << offset << ": " << buffer << '\n';
@@ -290,69 +462,408 @@ namespace ajson {
 
 	bool IsHex16(const char* data)
 	{
-		if((data[0] < '0' || data[0] > '9') && (data[0] < 'a' || data[0] > 'f') && (data[0] < 'A' || data[0] > 'Z'))
+		if((data[0] < '0' || data[0] > '9') && (data[0] < 'a' || data[0] > 'f') && (data[0] < 'A' || data[0] > 'F'))
 			return false;
-		if((data[1] < '0' || data[1] > '9') && (data[1] < 'a' || data[1] > 'f') && (data[1] < 'A' || data[1] > 'Z'))
+		if((data[1] < '0' || data[1] > '9') && (data[1] < 'a' || data[1] > 'f') && (data[1] < 'A' || data[1] > 'F'))
 			return false;
 
 		return true;
 	}
 
+	Arena::Arena(size_t blockSize) {
+		m_blocks = nullptr;
+		m_current = nullptr;
+		m_end = nullptr;
+		m_blockSize = blockSize;
+	}
+
+	Arena::~Arena() {
+		while(m_blocks != nullptr) {
+			Block* next = m_blocks->next;
+			free(m_blocks);
+			m_blocks = next;
+		}
+	}
+
+	void* Arena::AllocateBlock(size_t size) {
+		// Grow geometrically so large documents need few blocks
+		size_t blockSize = m_blocks != nullptr ? m_blocks->size * 2 : m_blockSize;
+		if(blockSize > MaxBlockSize) {
+			blockSize = MaxBlockSize;
+		}
+		if(blockSize < size) {
+			blockSize = size;
+		}
+
+		const size_t headerSize = (sizeof(Block) + Alignment - 1) & ~(Alignment - 1);
+		Block* block = static_cast<Block*>(malloc(headerSize + blockSize));
+		if(block == nullptr) {
+			throw std::bad_alloc();
+		}
+
+		block->size = blockSize;
+		block->next = m_blocks;
+		m_blocks = block;
+
+		char* memory = reinterpret_cast<char*>(block) + headerSize;
+		m_current = memory + size;
+		m_end = memory + blockSize;
+		return memory;
+	}
+
+	void Arena::Reset() {
+		if(m_blocks == nullptr) {
+			return;
+		}
+
+		// Keep the largest regular block for the next document, one-off blocks for oversized allocations are freed
+		Block* keep = nullptr;
+		for(Block* block = m_blocks;block != nullptr;block = block->next) {
+			if(block->size <= MaxBlockSize && (keep == nullptr || block->size > keep->size)) {
+				keep = block;
+			}
+		}
+
+		Block* block = m_blocks;
+		while(block != nullptr) {
+			Block* next = block->next;
+			if(block != keep) {
+				free(block);
+			}
+			block = next;
+		}
+
+		m_blocks = keep;
+		if(keep == nullptr) {
+			m_current = nullptr;
+			m_end = nullptr;
+			return;
+		}
+		keep->next = nullptr;
+
+		const size_t headerSize = (sizeof(Block) + Alignment - 1) & ~(Alignment - 1);
+		m_current = reinterpret_cast<char*>(keep) + headerSize;
+		m_end = m_current + keep->size;
+	}
+
+	void NodeString::Assign(const char* data, size_t size, Arena* arena) {
+		if(size <= InlineCapacity) {
+			// Copy first, 'data' may point into our own buffer
+			char bytes[InlineCapacity];
+			memcpy(bytes, data, size);
+			Clear();
+			memcpy(m_bytes, bytes, size);
+			m_bytes[InlineCapacity] = static_cast<char>(size);
+			return;
+		}
+
+		// Reuse an owned heap buffer that is large enough, arena buffers may be interned keys shared with other nodes
+		char* buffer;
+		if(static_cast<uint8_t>(m_bytes[InlineCapacity]) == HeapTag && size <= Size()) {
+			buffer = const_cast<char*>(Data());
+			memmove(buffer, data, size);
+		} else {
+			buffer = arena != nullptr ? static_cast<char*>(arena->Allocate(size)) : new char[size];
+			memcpy(buffer, data, size);
+			Clear();
+			m_bytes[InlineCapacity] = static_cast<char>(arena != nullptr ? ArenaTag : HeapTag);
+		}
+
+		uint32_t length = static_cast<uint32_t>(size);
+		memcpy(m_bytes, &buffer, sizeof(buffer));
+		memcpy(m_bytes + sizeof(char*), &length, sizeof(length));
+	}
+
+	void NodeString::AssignShared(const char* data, size_t size) {
+		if(size <= InlineCapacity) {
+			Assign(data, size, nullptr);
+			return;
+		}
+
+		Clear();
+		uint32_t length = static_cast<uint32_t>(size);
+		memcpy(m_bytes, &data, sizeof(data));
+		memcpy(m_bytes + sizeof(char*), &length, sizeof(length));
+		m_bytes[InlineCapacity] = static_cast<char>(ArenaTag);
+	}
+
+	void NodeString::Clear() {
+		// Arena buffers are released with the document
+		if(static_cast<uint8_t>(m_bytes[InlineCapacity]) == HeapTag) {
+			delete[] Data();
+		}
+		m_bytes[InlineCapacity] = 0;
+	}
+
+	void NodeList::Insert(uint32_t n, Node* node, Arena* arena) {
+		if(m_size == m_capacity) {
+			Reserve(m_size + 1, arena);
+		}
+		memmove(m_items + n + 1, m_items + n, (m_size - n) * sizeof(Node*));
+		m_items[n] = node;
+		m_size++;
+	}
+
+	void NodeList::Erase(uint32_t n) {
+		memmove(m_items + n, m_items + n + 1, (m_size - n - 1) * sizeof(Node*));
+		m_size--;
+	}
+
+	void NodeList::Reserve(uint32_t capacity, Arena* arena) {
+		if(capacity <= m_capacity) {
+			return;
+		}
+		if(capacity < m_capacity * 2) {
+			capacity = m_capacity * 2;
+		}
+		if(capacity < 4) {
+			capacity = 4;
+		}
+
+		Node** items = arena != nullptr ? static_cast<Node**>(arena->Allocate(capacity * sizeof(Node*))) : new Node*[capacity];
+		if(m_size > 0) {
+			memcpy(items, m_items, m_size * sizeof(Node*));
+		}
+		Free(arena);
+
+		m_items = items;
+		m_capacity = capacity;
+	}
+
+	void NodeList::Free(Arena* arena) {
+		if(arena == nullptr) {
+			delete[] m_items;
+		}
+		m_items = nullptr;
+		m_capacity = 0;
+	}
+
+	void PackedArray::Reserve(uint32_t capacity, size_t elementSize, Arena* arena) {
+		if(capacity <= m_capacity) {
+			return;
+		}
+		if(capacity < m_capacity * 2) {
+			capacity = m_capacity * 2;
+		}
+		if(capacity < 8) {
+			capacity = 8;
+		}
+
+		void* items = arena != nullptr ? arena->Allocate(capacity * elementSize) : new char[capacity * elementSize];
+		if(m_size > 0) {
+			memcpy(items, m_items, m_size * elementSize);
+		}
+		Free(arena);
+
+		m_items = items;
+		m_capacity = capacity;
+	}
+
+	void PackedArray::Free(Arena* arena) {
+		if(arena == nullptr) {
+			delete[] static_cast<char*>(m_items);
+		}
+		m_items = nullptr;
+		m_capacity = 0;
+	}
+
+	static uint32_t HashKey(const char* data, size_t length) {
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for(size_t i = 0;i < length;i++) {
+			hash ^= static_cast<uint8_t>(data[i]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	Document::Document(size_t blockSize) : m_arena{blockSize} {
+		m_keyCount = 0;
+		m_root = nullptr;
+		m_packArrays = false;
+	}
+
+	Document::~Document() {
+		Reset();
+	}
+
+	Node* Document::CreateRoot(NodeType type) {
+		m_root = new(m_arena.Allocate(sizeof(Node))) Node(this, type);
+		return m_root;
+	}
+
+	uint32_t Document::FindKeySlot(const char* data, uint32_t size, uint32_t hash) const {
+		uint32_t mask = static_cast<uint32_t>(m_keys.size()) - 1;
+		uint32_t slot = hash & mask;
+		while(m_keys[slot].data != nullptr) {
+			const KeySlot& current = m_keys[slot];
+			if(current.hash == hash && current.size == size && memcmp(current.data, data, size) == 0) {
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+	const char* Document::InternKey(const char* data, uint32_t size) {
+		// Keep load factor at or below one half
+		if((m_keyCount + 1) * 2 > m_keys.size()) {
+			std::vector<KeySlot> keys(m_keys.empty() ? 64 : m_keys.size() * 2);
+			keys.swap(m_keys);
+			for(size_t i = 0;i < keys.size();i++) {
+				if(keys[i].data != nullptr) {
+					m_keys[FindKeySlot(keys[i].data, keys[i].size, keys[i].hash)] = keys[i];
+				}
+			}
+		}
+
+		uint32_t hash = HashKey(data, size);
+		KeySlot& slot = m_keys[FindKeySlot(data, size, hash)];
+		if(slot.data == nullptr) {
+			char* copy = static_cast<char*>(m_arena.Allocate(size));
+			memcpy(copy, data, size);
+			slot.data = copy;
+			slot.size = size;
+			slot.hash = hash;
+			m_keyCount++;
+		}
+		return slot.data;
+	}
+
+	const char* Document::FindKey(const char* data, uint32_t size, uint32_t hash) const {
+		if(m_keyCount == 0) {
+			return nullptr;
+		}
+		return m_keys[FindKeySlot(data, size, hash)].data;
+	}
+
+	std::vector<uint8_t>* Document::CreateBlob() {
+		std::vector<uint8_t>* blob = new std::vector<uint8_t>();
+		m_blobs.push_back(blob);
+		return blob;
+	}
+
+	void Document::Reset() {
+		// Node destructors are skipped, names, strings and child lists live in the arena.
+		// Blobs use the public std::vector<uint8_t> type and are the only heap allocations.
+		for(size_t i = 0;i < m_blobs.size();i++) {
+			delete m_blobs[i];
+		}
+		m_blobs.clear();
+
+		// Interned names are in the arena, the table keeps its capacity for the next document
+		std::fill(m_keys.begin(), m_keys.end(), KeySlot());
+		m_keyCount = 0;
+
+		m_arena.Reset();
+		m_root = nullptr;
+	}
+
 	Node::Node(enum NodeType type, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
 		m_parent = nullptr;
-		m_name = name;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
 
 		m_type = type;
-		if(m_type == STRING_T) {
-			m_value.stringValue = new std::string();
-		} else if(m_type == BLOB_T) {
-			m_value.blobValue = new std::vector<uint8_t>();
-		}
+		AllocateValue();
+	}
+
+	Node::Node(Document* document, enum NodeType type) {
+		m_parent = nullptr;
+		m_document = document;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
+
+		m_type = type;
+		AllocateValue();
 	}
 
 	Node::Node(int32_t intValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
+		m_parent = nullptr;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
+
+		m_type = INT_T;
+		m_value.intValue = intValue;
+	}
+
+	Node::Node(int64_t intValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
 		m_parent = nullptr;
-		m_name = name;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
 
 		m_type = INT_T;
 		m_value.intValue = intValue;
 	}
 
 	Node::Node(float floatValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
+		m_parent = nullptr;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
+
+		m_type = FLOAT_T;
+		m_value.floatValue = floatValue;
+	}
+
+	Node::Node(double floatValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
 		m_parent = nullptr;
-		m_name = name;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
 
 		m_type = FLOAT_T;
 		m_value.floatValue = floatValue;
 	}
 
 	Node::Node(bool boolValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
 		m_parent = nullptr;
-		m_name = name;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
 
 		m_type = BOOL_T;
 		m_value.boolValue = boolValue;
 	}
 
 	Node::Node(const std::string& stringValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
 		m_parent = nullptr;
-		m_name = name;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
 
 		m_type = STRING_T;
-		m_value.stringValue = new std::string(stringValue);
+		new(&m_value.stringValue) NodeString();
+		m_value.stringValue.Assign(stringValue.data(), stringValue.size(), nullptr);
 	}
 
 	Node::Node(const std::vector<uint8_t>& blobValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
 		m_parent = nullptr;
-		m_name = name;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
 
 		m_type = BLOB_T;
 		m_value.blobValue = new std::vector<uint8_t>(blobValue);
 	}
 
 	Node::Node(std::vector<uint8_t>&& blobValue, const std::string& name) {
+		m_name.Assign(name.data(), name.size(), nullptr);
 		m_parent = nullptr;
-		m_name = name;
+		m_document = nullptr;
+		m_keyIndex = nullptr;
+		m_packedType = NULL_T;
 
 		m_type = BLOB_T;
 		m_value.blobValue = new std::vector<uint8_t>();
@@ -360,100 +871,152 @@ namespace ajson {
 	}
 
 	Node::Node(Node&& node) {
-		m_parent = node.m_parent;
-		node.m_parent = nullptr;
+		// The source loses its name
+		if(node.m_parent != nullptr) {
+			node.m_parent->DropKeyIndex();
+		}
+		m_name.Take(node.m_name);
 
-		m_name = node.m_name;
+		// A freshly constructed node is not part of any tree yet, but stays in the source's document
+		m_parent = nullptr;
+		m_document = node.m_document;
 
+		// The index points to the children, which are taken over as they are
 		m_type = node.m_type;
+		m_packedType = node.m_packedType;
+		m_value = node.m_value;
+		m_keyIndex = node.m_keyIndex;
 		node.m_type = NULL_T;
+		node.m_packedType = NULL_T;
+		node.m_keyIndex = nullptr;
 
-		if(m_type == STRING_T) {
-			m_value.stringValue = node.m_value.stringValue;
-			node.m_value.stringValue = nullptr;
-		} else if(m_type == INT_T) {
-			m_value.intValue = node.m_value.intValue;
-		} else if(m_type == FLOAT_T) {
-			m_value.floatValue = node.m_value.floatValue;
-		} else if(m_type == BOOL_T) {
-			m_value.boolValue = node.m_value.boolValue;
-		} else if(m_type == BLOB_T) {
-			m_value.blobValue = node.m_value.blobValue;
-			node.m_value.blobValue = nullptr;
+		// Children are not moved, only their parent pointer changes
+		if(IsContainer() && !IsPacked()) {
+			for(uint32_t i = 0;i < m_value.children.Size();i++) {
+				m_value.children[i]->m_parent = this;
+			}
 		}
 
-		m_children = std::move(node.m_children);
-
-		// Reset parent pointers
-		for(int i = 0;i < m_children.size();i++) {
-			m_children[i].m_parent = this;
+		if(node.m_parent != nullptr) {
+			node.m_parent->BuildKeyIndex();
 		}
 	}
 
 	void Node::operator=(Node&& node) {
-		m_parent = node.m_parent;
-		node.m_parent = nullptr;
+		if(&node == this) {
+			return;
+		}
 
-		m_name = std::move(node.m_name);
+		// Release current value and children, the node keeps its place in the tree under a new name
+		RemoveAllChildren();
+		FreeValue();
+		if(m_parent != nullptr) {
+			m_parent->DropKeyIndex();
+		}
+		if(node.m_parent != nullptr) {
+			node.m_parent->DropKeyIndex();
+		}
 
-		m_type = node.m_type;
-		node.m_type = NULL_T;
+		// Copies instead of stealing when the source belongs to another document
+		if(node.m_document == m_document) {
+			m_name.Clear();
+			m_name.Take(node.m_name);
+		} else {
+			if(node.m_type == COMMENT_T) {
+				m_name.Assign(node.m_name.Data(), node.m_name.Size(), GetArena());
+			} else {
+				AssignName(node.m_name.Data(), node.m_name.Size());
+			}
+			node.m_name.Clear();
+		}
+
+		if(node.m_document == m_document) {
+			m_type = node.m_type;
+			m_packedType = node.m_packedType;
+			m_value = node.m_value;
+			m_keyIndex = node.m_keyIndex;
+			node.m_type = NULL_T;
+			node.m_packedType = NULL_T;
+			node.m_keyIndex = nullptr;
+
+			if(IsContainer() && !IsPacked()) {
+				for(uint32_t i = 0;i < m_value.children.Size();i++) {
+					m_value.children[i]->m_parent = this;
+				}
+			}
+			ReindexParents(node);
+			return;
+		}
 
+		// Different owners, allocate storage from ours and move the subtree over node by node
+		node.Unpack();
+		node.DropKeyIndex();
+		m_type = node.m_type;
 		if(m_type == STRING_T) {
-			m_value.stringValue = node.m_value.stringValue;
-			node.m_value.stringValue = nullptr;
-		} else if(m_type == INT_T) {
-			m_value.intValue = node.m_value.intValue;
-		} else if(m_type == FLOAT_T) {
-			m_value.floatValue = node.m_value.floatValue;
-		} else if(m_type == BOOL_T) {
-			m_value.boolValue = node.m_value.boolValue;
+			AllocateValue();
+			m_value.stringValue.Assign(node.m_value.stringValue.Data(), node.m_value.stringValue.Size(), GetArena());
 		} else if(m_type == BLOB_T) {
-			m_value.blobValue = node.m_value.blobValue;
-			node.m_value.blobValue = nullptr;
+			AllocateValue();
+			(*m_value.blobValue) = std::move(*node.m_value.blobValue);
+		} else if(IsContainer()) {
+			AllocateValue();
+			for(uint32_t i = 0;i < node.m_value.children.Size();i++) {
+				// Detached first, the source is emptied anyway and doesn't need its names indexed
+				Node* source = node.m_value.children[i];
+				source->m_parent = nullptr;
+				Node* child = NewNode(NULL_T, "");
+				*child = std::move(*source);
+				LinkChild(child);
+			}
+		} else {
+			m_value = node.m_value;
 		}
 
-		m_children = std::move(node.m_children);
+		node.RemoveAllChildren();
+		node.FreeValue();
+		ReindexParents(node);
+	}
 
-		// Reset parent pointers
-		for(int i = 0;i < m_children.size();i++) {
-			m_children[i].m_parent = this;
+	void Node::ReindexParents(Node& source) {
+		if(m_parent != nullptr) {
+			m_parent->BuildKeyIndex();
+		}
+		if(source.m_parent != nullptr) {
+			source.m_parent->BuildKeyIndex();
 		}
 	}
 
 	Node::~Node() {
+		// Unlink from parent without deleting, we are already being destroyed
 		if(m_parent != nullptr) {
-			m_parent->RemoveChild(this);
+			m_parent->ReleaseChild(this);
 		}
 
-		for(std::vector<Node>::iterator it = m_children.begin();it != m_children.end();it++) {
-			it->m_parent = nullptr;
+		RemoveAllChildren();
+		DropKeyIndex();
+		FreeValue();
+		m_name.Clear();
+	}
+
+	uint32_t Node::Children() const {
+		if(!IsContainer()) {
+			return 0;
 		}
 
-		if(m_type == STRING_T) {
-			if(m_value.stringValue != nullptr) {
-				delete m_value.stringValue;
-				m_value.stringValue = nullptr;
-			}
-		} else if(m_type == BLOB_T) {
-			if(m_value.blobValue != nullptr) {
-				delete m_value.blobValue;
-				m_value.blobValue = nullptr;
-			}
+		if(IsPacked()) {
+			return m_value.packedValue.Size();
 		}
-	}
 
-	uint16_t Node::Children() const {
-		return m_children.size();
+		return m_value.children.Size();
 	}
 
-	uint16_t Node::GetDepth() const {
+	uint32_t Node::GetDepth() const {
 		if(m_parent == nullptr)
 		{
 			return 0;
 		}
 
-		uint16_t depth = 1;
+		uint32_t depth = 1;
 
 		Node* pParent = m_parent;
 		while(pParent->m_parent != nullptr)
@@ -491,22 +1054,14 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		m_children.push_back(std::move(*node));
-		m_children[currentChild].m_parent = this;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
-		}
+		Unpack();
+		Node* child = NewNode(NULL_T, "");
+		*child = std::move(*node);
 
-		return &m_children[currentChild];
+		return LinkChild(child);
 	}
 
-	Node* Node::AddChild(Node* node, uint16_t index) {
+	Node* Node::AddChild(Node* node, uint32_t index) {
 		if(node->m_parent != nullptr) {
 			// node already has a parent
 			return nullptr;
@@ -527,89 +1082,204 @@ namespace ajson {
 			throw e;
 		}
 
-		std::vector<Node>::iterator it = m_children.begin();
-		it += index;
-		m_children.insert(it, std::move(*node));
-		m_children[index].m_parent = this;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
+		Unpack();
+		if(index > m_value.children.Size()) {
+			index = m_value.children.Size();
 		}
 
-		return &m_children[index];
-	}
+		Node* child = NewNode(NULL_T, "");
+		*child = std::move(*node);
+		child->m_parent = this;
+		m_value.children.Insert(index, child, GetArena());
+		DropKeyIndex();
+		BuildKeyIndex();
 
-	void Node::RemoveChild(uint16_t n) {
-		m_children[n].m_parent = nullptr;
-		m_children.erase(m_children.begin() + n);
+		return child;
+	}
 
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
+	void Node::RemoveChild(uint32_t n) {
+		if(n >= Children()) {
+			return;
 		}
+
+		Unpack();
+
+		Node* child = m_value.children[n];
+		m_value.children.Erase(n);
+		DropKeyIndex();
+		BuildKeyIndex();
+
+		child->m_parent = nullptr;
+		FreeNode(child);
 	}
 
 	void Node::RemoveChild(Node* node) {
-		for(std::vector<Node>::iterator it = m_children.begin();it != m_children.end();it++) {
+		// Packed elements have no nodes
+		if(!IsContainer() || IsPacked()) {
+			return;
+		}
+
+		for(uint32_t i = 0;i < m_value.children.Size();i++) {
 			// node is a child of this
-			if(node == &(*it)) {
+			if(node == m_value.children[i]) {
+				m_value.children.Erase(i);
+				DropKeyIndex();
+				BuildKeyIndex();
 				node->m_parent = nullptr;
-				m_children.erase(it);
+				FreeNode(node);
 				break;
 			}
 		}
+	}
 
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
+	void Node::ReleaseChild(Node* node) {
+		for(uint32_t i = 0;i < m_value.children.Size();i++) {
+			if(node == m_value.children[i]) {
+				m_value.children.Erase(i);
+				DropKeyIndex();
+				BuildKeyIndex();
+				node->m_parent = nullptr;
+				break;
 			}
 		}
 	}
 
+	void Node::SpliceChildren(Node* node) {
+		NodeList& children = node->m_value.children;
+		m_value.children.Reserve(m_value.children.Size() + children.Size(), GetArena());
+
+		for(uint32_t i = 0;i < children.Size();i++) {
+			children[i]->m_parent = this;
+			m_value.children.Append(children[i], GetArena());
+		}
+
+		children.Clear();
+		node->DropKeyIndex();
+		DropKeyIndex();
+		BuildKeyIndex();
+	}
+
 	void Node::RemoveAllChildren() {
-		for(std::vector<Node>::iterator it = m_children.begin();it != m_children.end();it++) {
-			it->m_parent = nullptr;
+		// An emptied array starts over as a node list
+		if(IsPacked()) {
+			m_value.packedValue.Free(GetArena());
+			m_packedType = NULL_T;
+			new(&m_value.children) NodeList();
+			return;
+		}
+
+		if(!IsContainer() || m_value.children.Empty()) {
+			return;
+		}
+
+		DropKeyIndex();
+
+		// Document nodes own nothing outside the arena, dropping the links is enough
+		if(m_document != nullptr) {
+			m_value.children.Clear();
+			return;
 		}
 
-		m_children.resize(0);
+		// Free the subtree with an explicit work list instead of recursion.
+		// Every node is detached and emptied before delete, so each
+		// destructor runs in constant time and deep trees can't overflow the stack.
+		std::vector<Node*> pending(m_value.children.Begin(), m_value.children.End());
+		m_value.children.Clear();
+
+		while(!pending.empty()) {
+			Node* node = pending.back();
+			pending.pop_back();
+
+			if(node->IsContainer() && !node->IsPacked()) {
+				pending.insert(pending.end(), node->m_value.children.Begin(), node->m_value.children.End());
+				node->m_value.children.Clear();
+			}
+			node->m_parent = nullptr;
+			delete node;
+		}
 	}
 
-	Node* Node::CreateChild(NodeType t, const std::string& name) {
-		if(m_type != OBJECT_T && m_type != ARRAY_T) {
-			Exception e(AST_ERROR);
-			e.m_node = this;
-			e.m_errorString = "Cannot add child to non-container type\n";
-			throw e;
+	Node* Node::NewNode(NodeType type, const std::string& name) const {
+		if(m_document == nullptr) {
+			return new Node(type, name);
+		}
+
+		Node* node = new(m_document->m_arena.Allocate(sizeof(Node))) Node(m_document, type);
+		if(type == COMMENT_T) {
+			node->m_name.Assign(name.data(), name.size(), &m_document->m_arena);
+		} else {
+			node->AssignName(name.data(), name.size());
+		}
+		return node;
+	}
+
+	void Node::AssignName(const char* name, size_t length) {
+		if(m_document != nullptr && length > NodeString::InlineCapacity) {
+			m_name.AssignShared(m_document->InternKey(name, static_cast<uint32_t>(length)), length);
+		} else {
+			m_name.Assign(name, length, GetArena());
+		}
+	}
+
+	void Node::FreeNode(Node* node) {
+		if(node->m_document == nullptr) {
+			delete node;
+		} else {
+			// Memory stays in the arena until the document is reset
+			node->~Node();
 		}
+	}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].SetType(t);
-		m_children[currentChild].m_name = name;
+	void Node::AllocateValue() {
+		if(m_type == STRING_T) {
+			new(&m_value.stringValue) NodeString();
+		} else if(IsContainer()) {
+			new(&m_value.children) NodeList();
+			m_packedType = NULL_T;
+		} else if(m_type == BLOB_T) {
+			if(m_document == nullptr) {
+				m_value.blobValue = new std::vector<uint8_t>();
+			} else {
+				m_value.blobValue = m_document->CreateBlob();
+			}
+		}
+	}
 
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
+	void Node::FreeValue() {
+		// Document storage is released with the arena
+		if(m_type == STRING_T) {
+			m_value.stringValue.Clear();
+		} else if(IsPacked()) {
+			m_value.packedValue.Free(GetArena());
+			m_packedType = NULL_T;
+		} else if(IsContainer()) {
+			m_value.children.Free(GetArena());
+		} else if(m_document == nullptr) {
+			if(m_type == BLOB_T) {
+				delete m_value.blobValue;
 			}
+		} else if(m_type == BLOB_T) {
+			m_value.blobValue->clear();
 		}
 
-		return &m_children[currentChild];
+		m_type = NULL_T;
 	}
 
-	Node* Node::CreateObject(const std::string& name) {
+	Node* Node::LinkChild(Node* child) {
+		Unpack();
+		child->m_parent = this;
+		m_value.children.Append(child, GetArena());
+
+		if(m_keyIndex != nullptr) {
+			IndexChild(child);
+		} else if(m_type == OBJECT_T && m_value.children.Size() >= KeyIndexThreshold) {
+			BuildKeyIndex();
+		}
+
+		return child;
+	}
+
+	Node* Node::CreateChild(NodeType t, const std::string& name) {
 		if(m_type != OBJECT_T && m_type != ARRAY_T) {
 			Exception e(AST_ERROR);
 			e.m_node = this;
@@ -617,21 +1287,18 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node node(OBJECT_T);
-		m_children.push_back(std::move(node));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].m_name = name;
+		return LinkChild(NewNode(t, name));
+	}
 
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
+	Node* Node::CreateObject(const std::string& name) {
+		if(m_type != OBJECT_T && m_type != ARRAY_T) {
+			Exception e(AST_ERROR);
+			e.m_node = this;
+			e.m_errorString = "Cannot add child to non-container type\n";
+			throw e;
 		}
 
-		return &m_children[currentChild];
+		return LinkChild(NewNode(OBJECT_T, name));
 	}
 
 	Node* Node::CreateArray(const std::string& name) {
@@ -642,21 +1309,7 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node node(ARRAY_T);
-		m_children.push_back(std::move(node));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].m_name = name;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
-		}
-
-		return &m_children[currentChild];
+		return LinkChild(NewNode(ARRAY_T, name));
 	}
 
 	Node* Node::CreateInt(int32_t intValue, const std::string& name) {
@@ -667,22 +1320,22 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].SetInt(intValue);
-		m_children[currentChild].m_name = name;
+		Node* child = NewNode(INT_T, name);
+		child->m_value.intValue = intValue;
+		return LinkChild(child);
+	}
 
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
+	Node* Node::CreateInt64(int64_t intValue, const std::string& name) {
+		if(m_type != OBJECT_T && m_type != ARRAY_T) {
+			Exception e(AST_ERROR);
+			e.m_node = this;
+			e.m_errorString = "Cannot add child to non-container type\n";
+			throw e;
 		}
 
-		return &m_children[currentChild];
+		Node* child = NewNode(INT_T, name);
+		child->m_value.intValue = intValue;
+		return LinkChild(child);
 	}
 
 	Node* Node::CreateFloat(float floatValue, const std::string& name) {
@@ -693,22 +1346,22 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].SetFloat(floatValue);
-		m_children[currentChild].m_name = name;
+		Node* child = NewNode(FLOAT_T, name);
+		child->m_value.floatValue = floatValue;
+		return LinkChild(child);
+	}
 
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
+	Node* Node::CreateDouble(double floatValue, const std::string& name) {
+		if(m_type != OBJECT_T && m_type != ARRAY_T) {
+			Exception e(AST_ERROR);
+			e.m_node = this;
+			e.m_errorString = "Cannot add child to non-container type\n";
+			throw e;
 		}
 
-		return &m_children[currentChild];
+		Node* child = NewNode(FLOAT_T, name);
+		child->m_value.floatValue = floatValue;
+		return LinkChild(child);
 	}
 
 	Node* Node::CreateBool(bool boolValue, const std::string& name) {
@@ -719,22 +1372,9 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].SetBool(boolValue);
-		m_children[currentChild].m_name = name;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
-		}
-
-		return &m_children[currentChild];
+		Node* child = NewNode(BOOL_T, name);
+		child->m_value.boolValue = boolValue;
+		return LinkChild(child);
 	}
 
 	Node* Node::CreateString(const std::string& stringValue, const std::string& name) {
@@ -745,22 +1385,9 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].SetString(stringValue);
-		m_children[currentChild].m_name = name;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
-		}
-
-		return &m_children[currentChild];
+		Node* child = NewNode(STRING_T, name);
+		child->m_value.stringValue.Assign(stringValue.data(), stringValue.size(), GetArena());
+		return LinkChild(child);
 	}
 
 	Node* Node::CreateBlob(const std::vector<uint8_t>& blobValue, const std::string& name) {
@@ -771,22 +1398,9 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].SetBlob(blobValue);
-		m_children[currentChild].m_name = name;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
-		}
-
-		return &m_children[currentChild];
+		Node* child = NewNode(BLOB_T, name);
+		(*child->m_value.blobValue) = blobValue;
+		return LinkChild(child);
 	}
 
 	Node* Node::CreateBlob(std::vector<uint8_t>&& blobValue, const std::string& name) {
@@ -797,22 +1411,9 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].SetBlob(std::move(blobValue));
-		m_children[currentChild].m_name = name;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
-		}
-
-		return &m_children[currentChild];
+		Node* child = NewNode(BLOB_T, name);
+		(*child->m_value.blobValue) = std::move(blobValue);
+		return LinkChild(child);
 	}
 
 	Node* Node::CreateNull(const std::string& name) {
@@ -823,21 +1424,7 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].m_name = name;
-
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
-		}
-
-		return &m_children[currentChild];
+		return LinkChild(NewNode(NULL_T, name));
 	}
 
 	Node* Node::CreateComment(const std::string& value) {
@@ -848,22 +1435,30 @@ namespace ajson {
 			throw e;
 		}
 
-		uint32_t currentChild = m_children.size();
-		Node nullNode;
-		m_children.push_back(std::move(nullNode));
-		m_children[currentChild].m_parent = this;
-		m_children[currentChild].m_name = value;
-		m_children[currentChild].m_type = COMMENT_T;
+		return LinkChild(NewNode(COMMENT_T, value));
+	}
 
-		// Reset parent pointer
-		for(int i = 0;i < m_children.size();i++) {
-			Node* childNode = &m_children[i];
-			for(int j = 0;j < childNode->m_children.size();j++) {
-				childNode->m_children[j].m_parent = childNode;
-			}
+	void DestroyNode(Node* node, DestroyMode destroyMode) {
+		if(node == nullptr) {
+			return;
+		}
+
+		// Unlink on the calling thread so the parent is never touched concurrently
+		Node* parent = node->GetParent();
+		if(parent != nullptr) {
+			parent->ReleaseChild(node);
 		}
 
-		return &m_children[currentChild];
+		if(node->m_document != nullptr) {
+			// Nothing to free until the document is reset
+			Node::FreeNode(node);
+		} else if(destroyMode == DESTROY_IN_BACKGROUND) {
+			std::thread([node]() {
+				delete node;
+			}).detach();
+		} else {
+			delete node;
+		}
 	}
 
 	void Node::SetType(NodeType t) {
@@ -872,77 +1467,323 @@ namespace ajson {
 			return;
 		}
 
+		// Comments are not indexed by name
+		if((m_type == COMMENT_T || t == COMMENT_T) && m_parent != nullptr) {
+			m_parent->DropKeyIndex();
+		}
+
 		if(m_type == OBJECT_T || m_type == ARRAY_T) {
 			RemoveAllChildren();
 		}
 
-		if(m_type == STRING_T) {
-			if(m_value.stringValue != nullptr) {
-				delete m_value.stringValue;
-			}
-		} else if(m_type == BLOB_T) {
-			if(m_value.blobValue != nullptr) {
-				delete m_value.blobValue;
-			}
-		}
+		// Comment text stays as the name, which has to be interned like any other
+		bool comment = m_type == COMMENT_T;
 
-		if(t == STRING_T) {
-			m_value.stringValue = new std::string();
-		} else if(t == BLOB_T) {
-			m_value.blobValue = new std::vector<uint8_t>();
-		}
+		FreeValue();
 
 		m_type = t;
+		AllocateValue();
+
+		if(comment) {
+			AssignName(m_name.Data(), m_name.Size());
+		}
+
+		if(m_parent != nullptr) {
+			m_parent->BuildKeyIndex();
+		}
 	}
 
-	Node* Node::GetChild(uint16_t child) const {
+	Node* Node::GetChild(uint32_t child) const {
 		if(m_type != OBJECT_T && m_type != ARRAY_T) {
 			return nullptr;
 		}
 
-		if(child > m_children.size()) {
+		if(child >= Children()) {
+			return nullptr;
+		}
+
+		// Packed elements have no nodes
+		if(IsPacked()) {
 			return nullptr;
 		}
 
-		return const_cast<Node *>(&m_children[child]);
+		return m_value.children[child];
+	}
+
+	template<typename T> bool Node::Pack(NodeType type, T value) {
+		if(m_packedType != type) {
+			if(m_type != ARRAY_T || m_packedType != NULL_T || !m_value.children.Empty() || m_document == nullptr || !m_document->m_packArrays) {
+				return false;
+			}
+
+			// Empty arrays start packed with the type of their first element
+			m_value.children.Free(GetArena());
+			new(&m_value.packedValue) PackedArray();
+			m_packedType = type;
+		}
+
+		m_value.packedValue.Append(value, GetArena());
+		return true;
+	}
+
+	void Node::Unpack() {
+		if(m_packedType == NULL_T) {
+			return;
+		}
+
+		PackedArray packed = m_value.packedValue;
+		NodeType type = m_packedType;
+		m_packedType = NULL_T;
+		new(&m_value.children) NodeList();
+		m_value.children.Reserve(packed.Size(), GetArena());
+
+		for(uint32_t i = 0;i < packed.Size();i++) {
+			Node* child = NewNode(type, "");
+			if(type == INT_T) {
+				child->m_value.intValue = packed.Data<int64_t>()[i];
+			} else if(type == FLOAT_T) {
+				child->m_value.floatValue = packed.Data<double>()[i];
+			} else {
+				child->m_value.boolValue = packed.Data<bool>()[i];
+			}
+			LinkChild(child);
+		}
+
+		packed.Free(GetArena());
+	}
+
+	const int64_t* Node::GetPackedInts() const {
+		return m_packedType == INT_T ? m_value.packedValue.Data<int64_t>() : nullptr;
+	}
+
+	const double* Node::GetPackedDoubles() const {
+		return m_packedType == FLOAT_T ? m_value.packedValue.Data<double>() : nullptr;
+	}
+
+	const bool* Node::GetPackedBools() const {
+		return m_packedType == BOOL_T ? m_value.packedValue.Data<bool>() : nullptr;
+	}
+
+	void Node::AppendInt64(int64_t value) {
+		if(m_type != ARRAY_T) {
+			Exception e(AST_ERROR);
+			e.m_node = this;
+			e.m_errorString = "Cannot append value to non-array type\n";
+			throw e;
+		}
+
+		if(!Pack(INT_T, value)) {
+			Node* child = NewNode(INT_T, "");
+			child->m_value.intValue = value;
+			LinkChild(child);
+		}
+	}
+
+	void Node::AppendDouble(double value) {
+		if(m_type != ARRAY_T) {
+			Exception e(AST_ERROR);
+			e.m_node = this;
+			e.m_errorString = "Cannot append value to non-array type\n";
+			throw e;
+		}
+
+		if(!Pack(FLOAT_T, value)) {
+			Node* child = NewNode(FLOAT_T, "");
+			child->m_value.floatValue = value;
+			LinkChild(child);
+		}
+	}
+
+	void Node::AppendBool(bool value) {
+		if(m_type != ARRAY_T) {
+			Exception e(AST_ERROR);
+			e.m_node = this;
+			e.m_errorString = "Cannot append value to non-array type\n";
+			throw e;
+		}
+
+		if(!Pack(BOOL_T, value)) {
+			Node* child = NewNode(BOOL_T, "");
+			child->m_value.boolValue = value;
+			LinkChild(child);
+		}
+	}
+
+	/**
+	 * Open addressing table from name hash to the last child with that name.
+	 */
+	struct Node::KeyIndex
+	{
+		struct Slot
+		{
+			Node*		node;
+			uint32_t	hash;
+		};
+
+		Slot*		slots;
+		uint32_t	mask;
+		uint32_t	count;
+	};
+
+	void Node::BuildKeyIndex(bool recursive) {
+		std::vector<Node*> pending;
+		pending.push_back(this);
+
+		while(!pending.empty()) {
+			Node* node = pending.back();
+			pending.pop_back();
+
+			if(recursive && node->IsContainer() && !node->IsPacked()) {
+				for(uint32_t i = 0;i < node->m_value.children.Size();i++) {
+					if(node->m_value.children[i]->IsContainer()) {
+						pending.push_back(node->m_value.children[i]);
+					}
+				}
+			}
+
+			if(node->m_type != OBJECT_T || node->m_keyIndex != nullptr || node->m_value.children.Size() < KeyIndexThreshold) {
+				continue;
+			}
+
+			// Keep load factor at or below one half
+			uint32_t capacity = 16;
+			while(capacity < node->m_value.children.Size() * 2) {
+				capacity *= 2;
+			}
+
+			KeyIndex* index;
+			if(node->m_document == nullptr) {
+				index = new KeyIndex;
+				index->slots = new KeyIndex::Slot[capacity];
+			} else {
+				Arena& arena = node->m_document->m_arena;
+				index = static_cast<KeyIndex*>(arena.Allocate(sizeof(KeyIndex)));
+				index->slots = static_cast<KeyIndex::Slot*>(arena.Allocate(capacity * sizeof(KeyIndex::Slot)));
+			}
+			memset(index->slots, 0, capacity * sizeof(KeyIndex::Slot));
+			index->mask = capacity - 1;
+			index->count = 0;
+
+			// Inserting in order keeps the last occurrence of duplicate names
+			node->m_keyIndex = index;
+			for(uint32_t i = 0;i < node->m_value.children.Size();i++) {
+				node->IndexChild(node->m_value.children[i]);
+			}
+		}
+	}
+
+	void Node::IndexChild(Node* child) {
+		if(child->m_type == COMMENT_T) {
+			return;
+		}
+
+		if((m_keyIndex->count + 1) * 2 > m_keyIndex->mask + 1) {
+			// Rebuild at double size, the new child is already in the list
+			DropKeyIndex();
+			BuildKeyIndex();
+			return;
+		}
+
+		uint32_t hash = HashKey(child->m_name.Data(), child->m_name.Size());
+		uint32_t slot = hash & m_keyIndex->mask;
+		while(m_keyIndex->slots[slot].node != nullptr) {
+			KeyIndex::Slot& current = m_keyIndex->slots[slot];
+			if(current.hash == hash && current.node->m_name.Equals(child->m_name.Data(), child->m_name.Size())) {
+				current.node = child;
+				return;
+			}
+			slot = (slot + 1) & m_keyIndex->mask;
+		}
+
+		m_keyIndex->slots[slot].node = child;
+		m_keyIndex->slots[slot].hash = hash;
+		m_keyIndex->count++;
+	}
+
+	void Node::DropKeyIndex() {
+		if(m_keyIndex == nullptr) {
+			return;
+		}
+
+		// Document indexes are released with the arena
+		if(m_document == nullptr) {
+			delete[] m_keyIndex->slots;
+			delete m_keyIndex;
+		}
+		m_keyIndex = nullptr;
+	}
+
+	Arena* Node::GetArena() const {
+		return m_document != nullptr ? &m_document->m_arena : nullptr;
 	}
 
-	Node* Node::GetChild(const std::string& name) const {
+	Node* Node::GetChild(const char* name, size_t length) const {
 		if(m_type != OBJECT_T)
 		{
 			return nullptr;
 		}
 
-		Node* pNode = nullptr;
+		if(m_keyIndex != nullptr) {
+			uint32_t hash = HashKey(name, length);
+
+			// A long name that isn't interned was never given to a node of this document,
+			// one that is compares by address below
+			if(m_document != nullptr && length > NodeString::InlineCapacity) {
+				name = m_document->FindKey(name, static_cast<uint32_t>(length), hash);
+				if(name == nullptr) {
+					return nullptr;
+				}
+			}
+
+			uint32_t slot = hash & m_keyIndex->mask;
+			while(m_keyIndex->slots[slot].node != nullptr) {
+				const KeyIndex::Slot& current = m_keyIndex->slots[slot];
+				if(current.hash == hash && current.node->m_name.Equals(name, length)) {
+					return current.node;
+				}
+				slot = (slot + 1) & m_keyIndex->mask;
+			}
+			return nullptr;
+		}
 
-		for(std::vector<Node>::const_iterator it = m_children.begin();it != m_children.end();it++) {
-			if(it->GetName() == name) {
-				pNode = const_cast<Node *>(&(*it));
+		// Search backwards, the last occurrence wins
+		for(uint32_t i = m_value.children.Size();i > 0;i--) {
+			Node* child = m_value.children[i - 1];
+			if(child->m_type != COMMENT_T && child->m_name.Equals(name, length)) {
+				return child;
 			}
 		}
-		return pNode;
+		return nullptr;
 	}
 
 	Node* Node::GetFirstChild() const {
-		if(m_children.size() == 0) {
+		if(Children() == 0) {
 			return nullptr;
 		} else {
-			return const_cast<Node *>(&m_children[0]);
+			return GetChild(0);
 		}
 	}
 
 	Node* Node::GetLastChild() const {
-		size_t nChildren = m_children.size();
+		size_t nChildren = Children();
 
 		if(nChildren == 0) {
 			return nullptr;
 		} else {
-			return const_cast<Node *>(&m_children[nChildren - 1]);
+			return GetChild(nChildren - 1);
 		}
 	}
 
 	void Node::SetName(const std::string& name) {
-		m_name = name;
+		if(m_parent != nullptr) {
+			m_parent->DropKeyIndex();
+		}
+
+		AssignName(name.data(), name.size());
+
+		if(m_parent != nullptr) {
+			m_parent->BuildKeyIndex();
+		}
 	}
 
 	bool Node::GetBool() const {
@@ -956,7 +1797,7 @@ namespace ajson {
 
 	std::string Node::GetString() const {
 		if(m_type == STRING_T) {
-			return *m_value.stringValue;
+			return std::string(m_value.stringValue.Data(), m_value.stringValue.Size());
 		} else {
 			return std::string("");
 		}
@@ -965,9 +1806,9 @@ namespace ajson {
 	void Node::SetString(const std::string& val) {
 		if(m_type != STRING_T) {
 			SetType(STRING_T);
-			(*m_value.stringValue) = val;
+			m_value.stringValue.Assign(val.data(), val.size(), GetArena());
 		} else {
-			(*m_value.stringValue) = val;
+			m_value.stringValue.Assign(val.data(), val.size(), GetArena());
 		}
 	}
 
@@ -999,24 +1840,33 @@ namespace ajson {
 
 	std::string Node::GetComment() const {
 		if(m_type == COMMENT_T) {
-			return m_name;
+			return std::string(m_name.Data(), m_name.Size());
 		} else {
 			return std::string("");
 		}
 	}
 
 	void Node::SetComment(const std::string& val) {
+		// Comment text replaces the name
+		if(m_parent != nullptr) {
+			m_parent->DropKeyIndex();
+		}
+
 		if(m_type != COMMENT_T) {
 			SetType(COMMENT_T);
-			m_name = val;
+			m_name.Assign(val.data(), val.size(), GetArena());
 		} else {
-			m_name = val;
+			m_name.Assign(val.data(), val.size(), GetArena());
+		}
+
+		if(m_parent != nullptr) {
+			m_parent->BuildKeyIndex();
 		}
 	}
 
 	int32_t Node::GetInt() const {
 		if(m_type == INT_T) {
-			return m_value.intValue;
+			return static_cast<int32_t>(m_value.intValue);
 		} else if(m_type == FLOAT_T) {
 			return static_cast<int32_t>(m_value.floatValue);
 		} else {
@@ -1029,9 +1879,24 @@ namespace ajson {
 		m_value.intValue = val;
 	}
 
+	int64_t Node::GetInt64() const {
+		if(m_type == INT_T) {
+			return m_value.intValue;
+		} else if(m_type == FLOAT_T) {
+			return static_cast<int64_t>(m_value.floatValue);
+		} else {
+			return 0;
+		}
+	}
+
+	void Node::SetInt64(int64_t val) {
+		SetType(INT_T);
+		m_value.intValue = val;
+	}
+
 	float Node::GetFloat() const {
 		if(m_type == FLOAT_T) {
-			return m_value.floatValue;
+			return static_cast<float>(m_value.floatValue);
 		} else if(m_type == INT_T) {
 			return static_cast<float>(m_value.intValue);
 		} else {
@@ -1044,17 +1909,33 @@ namespace ajson {
 		m_value.floatValue = val;
 	}
 
-	Node::iterator Node::begin() const {
-		iterator it;
-		it.m_node = const_cast<Node *>(this);
-		it.m_child = 0;
-		return it;
-	}
-
-	Node::iterator Node::end() const {
-		Node::iterator it;
+	double Node::GetDouble() const {
+		if(m_type == FLOAT_T) {
+			return m_value.floatValue;
+		} else if(m_type == INT_T) {
+			return static_cast<double>(m_value.intValue);
+		} else {
+			return 0.0;
+		}
+	}
+
+	void Node::SetDouble(double val) {
+		SetType(FLOAT_T);
+		m_value.floatValue = val;
+	}
+
+	Node::iterator Node::begin() const {
+		iterator it;
+		it.m_node = const_cast<Node *>(this);
+		it.m_child = 0;
+		return it;
+	}
+
+	Node::iterator Node::end() const {
+		Node::iterator it;
 		it.m_node = const_cast<Node *>(this);
-		it.m_child = m_children.size();
+		// Packed elements have no nodes to visit
+		it.m_child = IsPacked() ? 0 : Children();
 		return it;
 	}
 
@@ -1110,9 +1991,27 @@ namespace ajson {
 
 		enum JsonTokens type;
 		uint32_t location, size;
+
+		/**
+		 * Parsed value of JSON_INT and JSON_FLOAT tokens.
+		 */
+		union
+		{
+			int64_t		intValue;
+			double		floatValue;
+		} value;
 	};
 
-	void ParseJsonNode(std::vector<JsonToken>& tokens, uint32_t& current, Node* node, char* parseBuffer, CommentPolicy commentPolicy) {
+	/**
+	 * Decoded text of a JSON_STRING token.
+	 */
+	static std::string TokenString(const char* parseBuffer, const JsonToken& token) {
+		std::string text;
+		EscapeString(&parseBuffer[token.location + 1], token.size, text);
+		return text;
+	}
+
+	void ParseJsonNode(std::vector<JsonToken>& tokens, uint32_t& current, Node* node, const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy) {
 		uint32_t temp;
 		bool comma = false;
 		bool started = false;
@@ -1121,20 +2020,18 @@ namespace ajson {
 
 		if(node->GetType() == OBJECT_T)
 		{
-			while(tokens[current].type != JSON_OBJ_END)
+			while(current >= tokens.size() || tokens[current].type != JSON_OBJ_END)
 			{
 				// Check for end of data
 				if(current >= tokens.size()) {
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data parsing object:", tokens[tokens.size() - 1].location));
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data parsing object:", tokens[tokens.size() - 1].location));
 				}
 
 				if(tokens[current].type == JSON_COMMENT) {
 					if(commentPolicy == ACCEPT_COMMENTS) {
 						Node tempNode(COMMENT_T);
 
-						parseBuffer[tokens[current].location + tokens[current].size - 2] = '\0';
-						tempNode.SetComment(std::string(&parseBuffer[tokens[current].location + 2]));
-						parseBuffer[tokens[current].location + tokens[current].size - 2] = '*';
+						tempNode.SetComment(std::string(&parseBuffer[tokens[current].location + 2], tokens[current].size - 4));
 
 						node->AddChild(&tempNode);
 					}
@@ -1143,56 +2040,48 @@ namespace ajson {
 				} else if(tokens[current].type == JSON_STRING) {
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token after value, was expecting ',':", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after value, was expecting ',':", tokens[current].location));
 					}
 					comma = false;
 					started = true;
 					if(current + 1 >= tokens.size()) {
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ':' after node name", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ':' after node name", tokens[current].location));
 					}
 					if(current + 2 >= tokens.size())
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected value after ':'", tokens[current + 1].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected value after ':'", tokens[current + 1].location));
 					}
 					if(tokens[current + 1].type != JSON_NAME_SEP)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token after node name, was expecting ':':", tokens[current + 1].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after node name, was expecting ':':", tokens[current + 1].location));
 					}
 					if(current + 3 >= tokens.size())
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unterminated Object, expected '}'", tokens[containerStart].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unterminated Object, expected '}'", tokens[containerStart].location));
 					}
 					if(tokens[current + 2].type == JSON_OBJ_BEGIN)
 					{
 						Node tempNode(OBJECT_T);
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 						current += 3;
 
 						Node* newNode = node->AddChild(&tempNode);
-						ParseJsonNode(tokens, current, newNode, parseBuffer, commentPolicy);
+						ParseJsonNode(tokens, current, newNode, parseBuffer, length, commentPolicy);
 					} else if(tokens[current + 2].type == JSON_ARR_BEGIN)
 					{
 						Node tempNode(ARRAY_T);
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 						current += 3;
 
 						Node* newNode = node->AddChild(&tempNode);
-						ParseJsonNode(tokens, current, newNode, parseBuffer, commentPolicy);
+						ParseJsonNode(tokens, current, newNode, parseBuffer, length, commentPolicy);
 					} else if(tokens[current + 2].type == JSON_STRING)
 					{
 						Node tempNode(STRING_T);
 
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 
-						parseBuffer[tokens[current + 2].location + tokens[current + 2].size + 1] = '\0';
-						tempNode.SetString(std::string(&parseBuffer[tokens[current + 2].location + 1]));
-						parseBuffer[tokens[current + 2].location + tokens[current + 2].size + 1] = '\"';
+						tempNode.SetString(TokenString(parseBuffer, tokens[current + 2]));
 
 						current += 3;
 						node->AddChild(&tempNode);
@@ -1200,16 +2089,9 @@ namespace ajson {
 					{
 						Node tempNode(INT_T);
 
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 
-						char tempChar = parseBuffer[tokens[current + 2].location + tokens[current + 2].size + 1];
-						parseBuffer[tokens[current + 2].location + tokens[current + 2].size + 1] = '\0';
-						int32_t tempInt;
-						sscanf(&parseBuffer[tokens[current + 2].location], "%i", &tempInt);
-						tempNode.SetInt(tempInt);
-						parseBuffer[tokens[current + 2].location + tokens[current + 2].size + 1] = tempChar;
+						tempNode.SetInt64(tokens[current + 2].value.intValue);
 
 						current += 3;
 						node->AddChild(&tempNode);
@@ -1217,13 +2099,9 @@ namespace ajson {
 					{
 						Node tempNode(FLOAT_T);
 
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 
-						float tempFloat;
-						sscanf(&parseBuffer[tokens[current + 2].location], "%f", &tempFloat);
-						tempNode.SetFloat(tempFloat);
+						tempNode.SetDouble(tokens[current + 2].value.floatValue);
 
 						current += 3;
 						node->AddChild(&tempNode);
@@ -1232,9 +2110,7 @@ namespace ajson {
 						Node tempNode(BOOL_T);
 						tempNode.SetBool(true);
 
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 
 						current += 3;
 						node->AddChild(&tempNode);
@@ -1243,9 +2119,7 @@ namespace ajson {
 						Node tempNode(BOOL_T);
 						tempNode.SetBool(false);
 
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 
 						current += 3;
 						node->AddChild(&tempNode);
@@ -1253,18 +2127,14 @@ namespace ajson {
 					{
 						Node tempNode(NULL_T);
 
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 
 						current += 3;
 						node->AddChild(&tempNode);
 					} else if(tokens[current + 2].type == JSON_BLOB) {
 						Node tempNode(BLOB_T);
 
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-						tempNode.SetName(std::string(&parseBuffer[tokens[current].location + 1]));
-						parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+						tempNode.SetName(TokenString(parseBuffer, tokens[current]));
 
 						std::vector<uint8_t> blob;
 						ParseBlobString(&parseBuffer[tokens[current + 2].location], tokens[current + 2].size, blob);
@@ -1274,52 +2144,50 @@ namespace ajson {
 						node->AddChild(&tempNode);
 					} else
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token:", tokens[current + 2].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token:", tokens[current + 2].location));
 					}
 				} else if(tokens[current].type == JSON_VALUE_SEP)
 				{
 					if(node->Children() == 0)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected ',' before any other nodes:", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected ',' before any other nodes:", tokens[current].location));
 					}
 
 					if(current + 1 >= tokens.size())
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data after ',':", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data after ',':", tokens[current].location));
 					}
 					if(tokens[current + 1].type == JSON_VALUE_SEP)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token after ',', was expecting node name:", tokens[current + 1].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after ',', was expecting node name:", tokens[current + 1].location));
 					}
 					if(tokens[current + 1].type != JSON_STRING) {
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token after ',', was expecting node name:", tokens[current + 1].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after ',', was expecting node name:", tokens[current + 1].location));
 					}
 
 					current++;
 					comma = true;
 				} else
 				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token:", tokens[current].location));
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token:", tokens[current].location));
 				}
 			}
 		} else
 		{
 			bool comma = false;
 			bool started = false;
-			while(tokens[current].type != JSON_ARR_END)
+			while(current >= tokens.size() || tokens[current].type != JSON_ARR_END)
 			{
-				if(current == tokens.size())
+				if(current >= tokens.size())
 				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data:", tokens[current - 1].location));
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data:", tokens[current - 1].location));
 				}
 
 				if(tokens[current].type == JSON_COMMENT) {
 					if(commentPolicy == ACCEPT_COMMENTS) {
 						Node tempNode(COMMENT_T);
 
-						parseBuffer[tokens[current].location + tokens[current].size - 2] = '\0';
-						tempNode.SetComment(std::string(&parseBuffer[tokens[current].location + 2]));
-						parseBuffer[tokens[current].location + tokens[current].size - 2] = '*';
+						tempNode.SetComment(std::string(&parseBuffer[tokens[current].location + 2], tokens[current].size - 4));
 
 						node->AddChild(&tempNode);
 					}
@@ -1329,16 +2197,14 @@ namespace ajson {
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
 					started = true;
 
 					Node tempNode(STRING_T);
-					parseBuffer[tokens[current].location + tokens[current].size + 1] = '\0';
-					tempNode.SetString(std::string(&parseBuffer[tokens[current].location + 1]));
-					parseBuffer[tokens[current].location + tokens[current].size + 1] = '\"';
+					tempNode.SetString(TokenString(parseBuffer, tokens[current]));
 
 					current++;
 					node->AddChild(&tempNode);
@@ -1346,77 +2212,55 @@ namespace ajson {
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
 					started = true;
 
-					Node tempNode(INT_T);
-					char tempChar = parseBuffer[tokens[current].location + tokens[current].size];
-					parseBuffer[tokens[current].location + tokens[current].size] = '\0';
-					int32_t tempInt;
-					sscanf(&parseBuffer[tokens[current].location], "%i", &tempInt);
-					parseBuffer[tokens[current].location + tokens[current].size] = tempChar;
-					tempNode.SetInt(tempInt);
-
+					node->AppendInt64(tokens[current].value.intValue);
 					current++;
-					node->AddChild(&tempNode);
 				} else if(tokens[current].type == JSON_FLOAT)
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
 					started = true;
 
-					Node tempNode(FLOAT_T);
-					char tempChar = parseBuffer[tokens[current].location + tokens[current].size];
-					parseBuffer[tokens[current].location + tokens[current].size] = '\0';
-					float tempFloat;
-					sscanf(&parseBuffer[tokens[current].location], "%f", &tempFloat);
-					parseBuffer[tokens[current].location + tokens[current].size] = tempChar;
-					tempNode.SetFloat(tempFloat);
-
+					node->AppendDouble(tokens[current].value.floatValue);
 					current++;
-					node->AddChild(&tempNode);
 				} else if(tokens[current].type == JSON_TRUE)
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
 					started = true;
 
-					Node tempNode(BOOL_T);
-					tempNode.SetBool(true);
-
+					node->AppendBool(true);
 					current++;
-					node->AddChild(&tempNode);
 				} else if(tokens[current].type == JSON_FALSE)
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
 					started = true;
 
-					Node tempNode(BOOL_T);
-					tempNode.SetBool(false);
-
+					node->AppendBool(false);
 					current++;
-					node->AddChild(&tempNode);
 				} else if(tokens[current].type == JSON_NULL)
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
@@ -1429,7 +2273,7 @@ namespace ajson {
 				} else if(tokens[current].type == JSON_BLOB) {
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
@@ -1438,7 +2282,7 @@ namespace ajson {
 					Node tempNode(BLOB_T);
 
 					std::vector<uint8_t> blob;
-					ParseBlobString(&parseBuffer[tokens[current + 2].location], tokens[current + 2].size, blob);
+					ParseBlobString(&parseBuffer[tokens[current].location], tokens[current].size, blob);
 					tempNode.SetBlob(std::move(blob));
 
 					current++;
@@ -1447,7 +2291,7 @@ namespace ajson {
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
@@ -1457,12 +2301,12 @@ namespace ajson {
 					current++;
 
 					Node* newNode = node->AddChild(&tempNode);
-					ParseJsonNode(tokens, current, newNode, parseBuffer, commentPolicy);
+					ParseJsonNode(tokens, current, newNode, parseBuffer, length, commentPolicy);
 				} else if(tokens[current].type == JSON_ARR_BEGIN)
 				{
 					if(node->Children() > 0 && !comma && started)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Expected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Expected ','", tokens[current].location));
 					}
 
 					comma = false;
@@ -1472,33 +2316,33 @@ namespace ajson {
 					current++;
 
 					Node* newNode = node->AddChild(&tempNode);
-					ParseJsonNode(tokens, current, newNode, parseBuffer, commentPolicy);
+					ParseJsonNode(tokens, current, newNode, parseBuffer, length, commentPolicy);
 				} else if(tokens[current].type == JSON_VALUE_SEP)
 				{
 					if(comma == true)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected ','", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected ','", tokens[current].location));
 					}
 
 					if(node->Children() == 0)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected ',' before any other nodes:", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected ',' before any other nodes:", tokens[current].location));
 					}
 
 					if(current + 1 >= tokens.size())
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data after ',':", tokens[current].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data after ',':", tokens[current].location));
 					}
 					if(tokens[current + 1].type == JSON_VALUE_SEP)
 					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token after ',':", tokens[current + 1].location));
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after ',':", tokens[current + 1].location));
 					}
 
 					comma = true;
 					current++;
 				} else
 				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token:", tokens[current].location));
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token:", tokens[current].location));
 				}
 			}
 		}
@@ -1506,58 +2350,189 @@ namespace ajson {
 		current++;
 	}
 
-	void ParseNumber(char* parseBuffer, std::vector<JsonToken>& tokens, uint32_t& processed, uint32_t length) {
-		bool isFloat = false;
+	static inline bool IsDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	/**
+	 * Powers of ten exactly representable as double.
+	 */
+	const static double ExactPowersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	/**
+	 * Correctly rounded conversion for numbers outside of the fast path, e.g. more than 19 significant digits.
+	 */
+	static double ParseDoubleSlow(const char* data, uint32_t size) {
+		char stackBuffer[64];
+		std::string heapBuffer;
+		char* text = stackBuffer;
+
+		if(size >= sizeof(stackBuffer)) {
+			heapBuffer.resize(size + 1);
+			text = &heapBuffer[0];
+		}
+
+		memcpy(text, data, size);
+		text[size] = '\0';
+
+		// strtod expects the decimal point of the current locale
+		char decimalPoint = localeconv()->decimal_point[0];
+		if(decimalPoint != '.') {
+			char* dot = strchr(text, '.');
+			if(dot != nullptr) {
+				*dot = decimalPoint;
+			}
+		}
+
+		return strtod(text, nullptr);
+	}
+
+	/**
+	 * Validates and converts a number in one pass, the value is stored in the token.
+	 * Up to 19 significant digits are accumulated into an integer. Integers are stored as is, floats with
+	 * a mantissa below 2^53 and a decimal exponent within [-22, 22] are converted with a single exact
+	 * multiplication or division (Clinger's fast path), anything else goes through strtod.
+	 */
+	static void ParseNumber(const char* parseBuffer, JsonToken& token, uint32_t& processed, uint32_t length) {
+		const static uint64_t MaxExactMantissa = 1ULL << 53;
+		const static int32_t MaxSignificantDigits = 19;
+
 		uint32_t start = processed;
-		while(processed != length)
-		{
-			if(parseBuffer[processed] == '.')
-			{
-				isFloat = true;
+		bool negative = false;
+		bool isFloat = false;
+		bool truncated = false;
+
+		uint64_t mantissa = 0;
+		int32_t digits = 0;
+		int32_t exponent = 0;
+
+		if(parseBuffer[processed] == '-') {
+			negative = true;
+			processed++;
+		}
+
+		if(processed == length || !IsDigit(parseBuffer[processed])) {
+			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Error parsing number:", start));
+		}
+
+		if(parseBuffer[processed] == '0') {
+			processed++;
+			if(processed != length && IsDigit(parseBuffer[processed])) {
+				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Error parsing number, leading zeros are not allowed:", start));
 			}
-			if((parseBuffer[processed] < '0' || parseBuffer[processed] > '9') && parseBuffer[processed] != '.' && parseBuffer[processed] != 'e' && parseBuffer[processed] != 'E' && parseBuffer[processed] != '-' && parseBuffer[processed] != '+')
-			{
-				break;
+		} else {
+			while(processed != length && IsDigit(parseBuffer[processed])) {
+				if(digits < MaxSignificantDigits) {
+					mantissa = mantissa * 10 + (parseBuffer[processed] - '0');
+					digits++;
+				} else {
+					truncated |= parseBuffer[processed] != '0';
+					exponent++;
+				}
+				processed++;
 			}
+		}
+
+		if(processed != length && parseBuffer[processed] == '.') {
+			isFloat = true;
 			processed++;
+
+			if(processed == length || !IsDigit(parseBuffer[processed])) {
+				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Error parsing number, expected digit after '.':", processed));
+			}
+
+			while(processed != length && IsDigit(parseBuffer[processed])) {
+				if(digits < MaxSignificantDigits) {
+					mantissa = mantissa * 10 + (parseBuffer[processed] - '0');
+					if(mantissa != 0) {
+						digits++;
+					}
+					exponent--;
+				} else {
+					truncated |= parseBuffer[processed] != '0';
+				}
+				processed++;
+			}
 		}
-		JsonToken token;
-		if(isFloat)
-		{
-			token.set(JSON_FLOAT, start, processed - start);
-			char tempChar = parseBuffer[processed];
-			parseBuffer[processed] = '\0';
-			float tempFloat;
-			if(!sscanf(&parseBuffer[start], "%f", &tempFloat))
-			{
-				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Error parsing number:", start));
+
+		if(processed != length && (parseBuffer[processed] == 'e' || parseBuffer[processed] == 'E')) {
+			isFloat = true;
+			processed++;
+
+			bool negativeExponent = false;
+			if(processed != length && (parseBuffer[processed] == '+' || parseBuffer[processed] == '-')) {
+				negativeExponent = parseBuffer[processed] == '-';
+				processed++;
 			}
-			parseBuffer[processed] = tempChar;
-			tokens.push_back(token);
-		} else
-		{
-			token.set(JSON_INT, start, processed - start);
-			char tempChar = parseBuffer[processed];
-			parseBuffer[processed] = '\0';
-			int32_t tempInt;
-			if(!sscanf(&parseBuffer[start], "%i", &tempInt))
-			{
-				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Error parsing number:", start));
+
+			if(processed == length || !IsDigit(parseBuffer[processed])) {
+				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Error parsing number, expected digit in exponent:", processed));
+			}
+
+			int32_t exponentValue = 0;
+			while(processed != length && IsDigit(parseBuffer[processed])) {
+				// Anything this large is out of range or zero anyway
+				if(exponentValue < 100000) {
+					exponentValue = exponentValue * 10 + (parseBuffer[processed] - '0');
+				}
+				processed++;
+			}
+
+			exponent += negativeExponent ? -exponentValue : exponentValue;
+		}
+
+		token.type = JSON_INT;
+		token.location = start;
+		token.size = processed - start;
+
+		if(!isFloat && exponent == 0) {
+			// Integers outside of int64 range are stored as float
+			if(negative && mantissa <= static_cast<uint64_t>(INT64_MAX) + 1) {
+				token.value.intValue = static_cast<int64_t>(0 - mantissa);
+				return;
+			} else if(!negative && mantissa <= static_cast<uint64_t>(INT64_MAX)) {
+				token.value.intValue = static_cast<int64_t>(mantissa);
+				return;
+			}
+		}
+
+		token.type = JSON_FLOAT;
+
+		double value;
+		if(mantissa == 0) {
+			value = 0.0;
+		} else if(!truncated && mantissa <= MaxExactMantissa && exponent >= -22 && exponent <= 22) {
+			value = static_cast<double>(mantissa);
+			if(exponent < 0) {
+				value /= ExactPowersOfTen[-exponent];
+			} else {
+				value *= ExactPowersOfTen[exponent];
+			}
+		} else {
+			value = ParseDoubleSlow(&parseBuffer[start], processed - start);
+			negative = false;
+
+			// Rejected rather than stored as infinity, which json can't represent
+			if(std::isinf(value)) {
+				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Error parsing number, out of the range of double:", start));
 			}
-			parseBuffer[processed] = tempChar;
-			tokens.push_back(token);
 		}
+
+		token.value.floatValue = negative ? -value : value;
 	}
 
-	static void ParseBlob(char* parseBuffer, std::vector<JsonToken>& tokens, uint32_t& processed, uint32_t length) {
+	static void ParseBlob(const char* parseBuffer, JsonToken& token, uint32_t& processed, uint32_t length) {
 		uint32_t start = processed;
 
 		// First character is supposed to be 'b', so increment 'processed'
 		processed++;
 
 		// Next character should be '"'
-		if(parseBuffer[processed] != '\"') {
-			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Error parsing blob, was expecting '\"' after b:", processed));
+		if(processed == length || parseBuffer[processed] != '\"') {
+			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Error parsing blob, was expecting '\"' after b:", processed));
 		}
 
 		processed++;
@@ -1580,44 +2555,102 @@ namespace ajson {
 
 			if(c == '/') {
 				if(processed + 2 >= length) {
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data parsing blob:", processed));
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data parsing blob:", processed));
 				}
 
 				if(!IsHex16(&parseBuffer[processed + 1])) {
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unknown blob character, expected Hex16:", processed));
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unknown blob character, expected Hex16:", processed));
 				}
 
 				processed += 3;
 				continue;
 			}
 
-			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unknown blob character:", processed));
+			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unknown blob character:", processed));
 		}
 
 		if(!closed) {
-			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unclosed blob:", start));
+			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unclosed blob:", start));
+		}
+
+		token.set(JSON_BLOB, start, processed - start);
+	}
+
+	/**
+	 * Returns the length of the UTF-8 sequence at 'processed', or 0 if it is malformed, truncated, overlong,
+	 * encodes a surrogate or a code point above U+10FFFF.
+	 */
+	static uint32_t Utf8SequenceLength(const char* parseBuffer, uint32_t processed, uint32_t length) {
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(&parseBuffer[processed]);
+		uint32_t available = length - processed;
+		uint8_t lead = data[0];
+
+		if(lead < 0x80) {
+			return 1;
+		}
+
+		uint32_t size;
+		uint8_t low = 0x80;
+		uint8_t high = 0xbf;
+
+		if(lead >= 0xc2 && lead <= 0xdf) {
+			size = 2;
+		} else if(lead >= 0xe0 && lead <= 0xef) {
+			size = 3;
+			if(lead == 0xe0) {
+				low = 0xa0;
+			} else if(lead == 0xed) {
+				high = 0x9f;
+			}
+		} else if(lead >= 0xf0 && lead <= 0xf4) {
+			size = 4;
+			if(lead == 0xf0) {
+				low = 0x90;
+			} else if(lead == 0xf4) {
+				high = 0x8f;
+			}
+		} else {
+			return 0;
+		}
+
+		if(available < size || data[1] < low || data[1] > high) {
+			return 0;
+		}
+
+		for(uint32_t i = 2;i < size;i++) {
+			if((data[i] & 0xc0) != 0x80) {
+				return 0;
+			}
 		}
 
-		JsonToken token(JSON_BLOB, start, processed - start);
-		tokens.push_back(token);
+		return size;
 	}
 
-	static void ParseComment(char* parseBuffer, std::vector<JsonToken>& tokens, uint32_t& processed, uint32_t length) {
+	static void ParseComment(const char* parseBuffer, JsonToken& token, uint32_t& processed, uint32_t length, Utf8Policy utf8Policy) {
 		uint32_t start = processed;
 		uint32_t end = start;
 
-		if(parseBuffer[processed + 1] != '*') {
-			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token, was expecting '*'", start + 1));
+		if(processed + 1 >= length || parseBuffer[processed + 1] != '*') {
+			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting '*'", start + 1));
 		}
 
 		bool closed = false;
 
 		processed += 2;
 		while(processed != length) {
+			if(utf8Policy == UTF8_VALIDATE && static_cast<uint8_t>(parseBuffer[processed]) >= 0x80) {
+				uint32_t size = Utf8SequenceLength(parseBuffer, processed, length);
+				if(size == 0) {
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Invalid UTF-8 in comment:", processed));
+				}
+				processed += size;
+				continue;
+			}
+
 			if(parseBuffer[processed] == '*') {
 				if(processed + 1 >= length) {
 					// Unterminated comment
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unterminated comment", start));
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unterminated comment", start));
 				}
 
 				if(parseBuffer[processed + 1] == '/') {
@@ -1627,301 +2660,2887 @@ namespace ajson {
 					end = processed;
 					break;
 				}
-			} else {
-				processed++;
 			}
+
+			processed++;
 		}
 
 		if(!closed) {
-			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unterminated comment", start));
+			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unterminated comment", start));
 		}
 
-		JsonToken token(JSON_COMMENT, start, end - start);
-		tokens.push_back(token);
+		token.set(JSON_COMMENT, start, end - start);
 	}
 
-	static void ParseTokens(std::vector<JsonToken>& tokens, char* parseBuffer, CommentPolicy commentPolicy) {
-		uint32_t processed = 0;
-		uint32_t length = strlen(parseBuffer);
+	static inline uint32_t TrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
 
-		JsonToken token;
+#if defined(AJSON_SIMD)
+#if defined(__AVX2__)
+	typedef __m256i SimdVector;
+	const static int SimdVectorBytes = 32;
 
-		uint32_t stringStart, stringEnd;
+	static inline SimdVector SimdLoad(const char* data) {
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+	}
 
-		while(processed != length)
-		{
-			switch(parseBuffer[processed])
-			{
-			case '{':
-				token.set(JSON_OBJ_BEGIN, processed);
-				tokens.push_back(token);
-				processed++;
-				break;
-			case '}':
-				token.set(JSON_OBJ_END, processed);
-				tokens.push_back(token);
-				processed++;
-				break;
-			case '[':
-				token.set(JSON_ARR_BEGIN, processed);
-				tokens.push_back(token);
-				processed++;
-				break;
-			case ']':
-				token.set(JSON_ARR_END, processed);
-				tokens.push_back(token);
-				processed++;
-				break;
-			case ',':
-				token.set(JSON_VALUE_SEP, processed);
-				tokens.push_back(token);
-				processed++;
-				break;
-			case ':':
-				token.set(JSON_NAME_SEP, processed);
-				tokens.push_back(token);
-				processed++;
-				break;
-			case '"':
-				stringStart = processed;
-				processed++;
-				while(processed != length)
-				{
-					if(parseBuffer[processed] == '"')
-					{
-						token.set(JSON_STRING, stringStart, processed - stringStart - 1);
-						tokens.push_back(token);
-						processed++;
-						break;
-					}
+	static inline SimdVector SimdEq(SimdVector v, char c) {
+		return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+	}
 
-					if(processed + 1 >= length)
-					{
-						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unterminated string:", processed));
-					}
+	static inline SimdVector SimdOr(SimdVector a, SimdVector b) {
+		return _mm256_or_si256(a, b);
+	}
 
-					if(parseBuffer[processed] == '\\')
-					{
-						if(processed + 2 >= length)
-						{
-							throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unterminated string:", processed + 1));
-						}
-						if(parseBuffer[processed + 1] == 'f' || parseBuffer[processed + 1] == 'n' || parseBuffer[processed + 1] == 'r' || parseBuffer[processed + 1] == 't' || parseBuffer[processed + 1] == 'b' || parseBuffer[processed + 1] == '\\' || parseBuffer[processed + 1] == '/' || parseBuffer[processed + 1] == '"')
-						{
-							processed += 2;
-						} else if(parseBuffer[processed + 1] == 'u')
-						{
-							if(processed + 6 >= length)
-							{
-								throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data when parsing hexadecimal escape sequence:", processed + 1));
-							}
-							if(!IsHex16(&parseBuffer[processed + 2]))
-							{
-								throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Escape sequence is not hexadecimal:", processed + 1));
-							}
-							processed += 6;
-						} else
-						{
-							throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unrecognized escape sequence", processed));
-						}
-					} else if(parseBuffer[processed] == '\n' || parseBuffer[processed] == '\f' || parseBuffer[processed] == '\r' || parseBuffer[processed] == '\t' || parseBuffer[processed] == '\b')
-					{
+	// Bytes 0x00 - 0x1f
+	static inline SimdVector SimdControl(SimdVector v) {
+		return _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v), _mm256_cmpgt_epi8(v, _mm256_set1_epi8(-1)));
+	}
 
-					} else
-					{
-						processed++;
-					}
-				}
-				break;
-			case 't':
-				if(processed + 4 >= length)
-				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data:", length));
-				}
-				if(parseBuffer[processed + 1] != 'r' || parseBuffer[processed + 2] != 'u' || parseBuffer[processed + 3] != 'e')
-				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token, was expecting 'true':", processed));
+	static inline uint64_t SimdMask(SimdVector v) {
+		return static_cast<uint32_t>(_mm256_movemask_epi8(v));
+	}
+#elif defined(AJSON_SSE2)
+	typedef __m128i SimdVector;
+	const static int SimdVectorBytes = 16;
+
+	static inline SimdVector SimdLoad(const char* data) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	}
+
+	static inline SimdVector SimdEq(SimdVector v, char c) {
+		return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+	}
+
+	static inline SimdVector SimdOr(SimdVector a, SimdVector b) {
+		return _mm_or_si128(a, b);
+	}
+
+	// Bytes 0x00 - 0x1f
+	static inline SimdVector SimdControl(SimdVector v) {
+		return _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(0x20), v), _mm_cmpgt_epi8(v, _mm_set1_epi8(-1)));
+	}
+
+	static inline uint64_t SimdMask(SimdVector v) {
+		return static_cast<uint16_t>(_mm_movemask_epi8(v));
+	}
+#endif
+
+	/**
+	 * 64 bytes of input split into vectors, classified into one bit per byte.
+	 */
+	struct SimdBlock
+	{
+		const static int Vectors = 64 / SimdVectorBytes;
+
+		SimdBlock(const char* data) {
+			for(int i = 0;i < Vectors;i++) {
+				parts[i] = SimdLoad(data + i * SimdVectorBytes);
+			}
+		}
+
+		uint64_t Eq(char c) const {
+			uint64_t bits = 0;
+			for(int i = 0;i < Vectors;i++) {
+				bits |= SimdMask(SimdEq(parts[i], c)) << (i * SimdVectorBytes);
+			}
+			return bits;
+		}
+
+		uint64_t Whitespace() const {
+			uint64_t bits = 0;
+			for(int i = 0;i < Vectors;i++) {
+				SimdVector v = parts[i];
+				SimdVector match = SimdOr(SimdOr(SimdEq(v, ' '), SimdEq(v, '\n')), SimdOr(SimdOr(SimdEq(v, '\r'), SimdEq(v, '\t')), SimdEq(v, '\f')));
+				bits |= SimdMask(match) << (i * SimdVectorBytes);
+			}
+			return bits;
+		}
+
+		// '{', '}', '[', ']', ':' and ','
+		uint64_t Operators() const {
+			uint64_t bits = 0;
+			for(int i = 0;i < Vectors;i++) {
+				SimdVector v = parts[i];
+				SimdVector match = SimdOr(SimdOr(SimdOr(SimdEq(v, '{'), SimdEq(v, '}')), SimdOr(SimdEq(v, '['), SimdEq(v, ']'))), SimdOr(SimdEq(v, ':'), SimdEq(v, ',')));
+				bits |= SimdMask(match) << (i * SimdVectorBytes);
+			}
+			return bits;
+		}
+
+		// Bytes 0x80 - 0xff
+		uint64_t NonAscii() const {
+			uint64_t bits = 0;
+			for(int i = 0;i < Vectors;i++) {
+				bits |= SimdMask(parts[i]) << (i * SimdVectorBytes);
+			}
+			return bits;
+		}
+
+		uint64_t Control() const {
+			uint64_t bits = 0;
+			for(int i = 0;i < Vectors;i++) {
+				bits |= SimdMask(SimdControl(parts[i])) << (i * SimdVectorBytes);
+			}
+			return bits;
+		}
+
+		SimdVector parts[Vectors];
+	};
+
+	/**
+	 * Sets every bit from a set bit up to (but excluding) the next set bit, i.e. turns quote positions into a string mask.
+	 */
+	static inline uint64_t PrefixXor(uint64_t bits) {
+#if defined(__PCLMUL__)
+		__m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, bits), _mm_set1_epi8(-1), 0);
+		return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+#else
+		bits ^= bits << 1;
+		bits ^= bits << 2;
+		bits ^= bits << 4;
+		bits ^= bits << 8;
+		bits ^= bits << 16;
+		bits ^= bits << 32;
+		return bits;
+#endif
+	}
+
+	/**
+	 * Stage 1 of the tokenizer. Classifies the input 64 bytes at a time and records the positions of
+	 * structural characters, string quotes and the first character of every other literal outside of strings.
+	 * Whitespace is never visited by the tokenizer afterwards.
+	 *
+	 * Input is indexed a window at a time so memory stays bounded on large buffers.
+	 * Comments, control characters inside strings, unterminated strings and, with UTF8_VALIDATE, malformed UTF-8
+	 * stop the indexer, the tokenizer then continues with the scalar path which handles comments and reports errors.
+	 */
+	class StructuralIndexer
+	{
+	public:
+		StructuralIndexer(const char* parseBuffer, uint32_t length, Utf8Policy utf8Policy) {
+			m_buffer = parseBuffer;
+			m_length = length;
+			m_utf8Policy = utf8Policy;
+			m_utf8Skip = 0;
+			m_blockStart = 0;
+			m_inString = 0;
+			m_escaped = 0;
+			m_literal = 0;
+			m_current = 0;
+			m_failed = false;
+			// Small inputs like single NDJSON records never fill a window
+			m_index.reserve(length < WindowSize ? length : WindowSize);
+		}
+
+		/**
+		 * Gets the next indexed position.
+		 * Returns false at the end of data or if indexing stopped, see Failed().
+		 */
+		inline bool Next(uint32_t& position) {
+			if(m_current == m_index.size()) {
+				if(!Refill()) {
+					return false;
 				}
-				token.set(JSON_TRUE, processed, 4);
-				tokens.push_back(token);
-				processed += 4;
-				break;
-			case 'f':
-				if(processed + 5 >= length)
-				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data:", length));
+			}
+
+			position = m_index[m_current];
+			m_current++;
+			return true;
+		}
+
+		bool Failed() const {
+			return m_failed;
+		}
+
+	private:
+		const static uint32_t WindowSize = 16384;
+
+		bool Refill() {
+			m_index.resize(0);
+			m_current = 0;
+
+			while(m_index.empty()) {
+				if(m_failed || m_blockStart >= m_length) {
+					return false;
 				}
-				if(parseBuffer[processed + 1] != 'a' || parseBuffer[processed + 2] != 'l' || parseBuffer[processed + 3] != 's' || parseBuffer[processed + 4] != 'e')
-				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token, was expecting 'false':", processed));
+
+				uint32_t windowEnd = m_blockStart + WindowSize;
+				if(windowEnd > m_length || windowEnd < m_blockStart) {
+					windowEnd = m_length;
 				}
-				token.set(JSON_FALSE, processed, 5);
-				tokens.push_back(token);
-				processed += 5;
-				break;
-			case 'n':
-				if(processed + 4 >= length)
-				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected end of data:", length));
+
+				while(m_blockStart < windowEnd) {
+					if(!IndexBlock()) {
+						m_failed = true;
+						m_index.resize(0);
+						return false;
+					}
+					m_blockStart += 64;
 				}
-				if(parseBuffer[processed + 1] != 'u' || parseBuffer[processed + 2] != 'l' || parseBuffer[processed + 3] != 'l')
-				{
-					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token, was expecting 'null':", processed));
+
+				if(m_blockStart >= m_length && m_inString) {
+					// Unterminated string
+					m_failed = true;
+					m_index.resize(0);
+					return false;
 				}
-				token.set(JSON_NULL, processed, 4);
-				tokens.push_back(token);
-				processed += 4;
-				break;
-			case 'b':
-				ParseBlob(parseBuffer, tokens, processed, length);
+			}
+
+			return true;
+		}
+
+		bool IndexBlock() {
+			char padded[64];
+			const char* data = &m_buffer[m_blockStart];
+
+			if(m_length - m_blockStart < 64) {
+				memset(padded, ' ', 64);
+				memcpy(padded, data, m_length - m_blockStart);
+				data = padded;
+			}
+
+			SimdBlock block(data);
+
+			if(m_utf8Policy == UTF8_VALIDATE && !ValidateUtf8(block.NonAscii())) {
+				return false;
+			}
+
+			uint64_t quotes = block.Eq('"');
+			uint64_t backslashes = block.Eq('\\');
+			uint64_t whitespace = block.Whitespace();
+			uint64_t operators = block.Operators();
+
+			// Characters following an odd number of backslashes are escaped
+			uint64_t escaped = m_escaped;
+			m_escaped = 0;
+			while(backslashes) {
+				uint32_t i = TrailingZeros(backslashes);
+				backslashes &= backslashes - 1;
+
+				if(escaped & (1ULL << i)) {
+					continue;
+				}
+
+				if(i == 63) {
+					m_escaped = 1;
+				} else {
+					escaped |= 1ULL << (i + 1);
+				}
+			}
+
+			quotes &= ~escaped;
+
+			// Opening quotes and string contents are set, closing quotes are not
+			uint64_t inString = PrefixXor(quotes) ^ m_inString;
+			m_inString = 0ULL - (inString >> 63);
+
+			if(block.Eq('/') & ~inString) {
+				// Comment
+				return false;
+			}
+
+			if(block.Control() & inString & ~quotes) {
+				return false;
+			}
+
+			uint64_t literal = ~(whitespace | operators | quotes | inString);
+			uint64_t literalStarts = literal & ~((literal << 1) | m_literal);
+			m_literal = literal >> 63;
+
+			uint64_t structurals = (operators & ~inString) | quotes | literalStarts;
+			if(m_length - m_blockStart < 64) {
+				structurals &= (1ULL << (m_length - m_blockStart)) - 1;
+			}
+
+			while(structurals) {
+				m_index.push_back(m_blockStart + TrailingZeros(structurals));
+				structurals &= structurals - 1;
+			}
+
+			return true;
+		}
+
+		/**
+		 * Checks the UTF-8 sequences starting in the current block, the last one may continue into the next block.
+		 * ASCII only blocks cost a single test.
+		 */
+		bool ValidateUtf8(uint64_t nonAscii) {
+			// Continuation bytes of a sequence from the previous block
+			nonAscii &= ~((1ULL << m_utf8Skip) - 1);
+			m_utf8Skip = 0;
+
+			while(nonAscii) {
+				uint32_t i = TrailingZeros(nonAscii);
+				uint32_t size = Utf8SequenceLength(m_buffer, m_blockStart + i, m_length);
+				if(size == 0) {
+					return false;
+				}
+
+				if(i + size >= 64) {
+					m_utf8Skip = i + size - 64;
+					break;
+				}
+				nonAscii &= ~(((1ULL << size) - 1) << i);
+			}
+
+			return true;
+		}
+
+		const char*				m_buffer;
+		uint32_t				m_length;
+		uint32_t				m_blockStart;
+		Utf8Policy				m_utf8Policy;
+
+		// State carried between blocks
+		uint64_t				m_inString;
+		uint64_t				m_escaped;
+		uint64_t				m_literal;
+		uint32_t				m_utf8Skip;
+
+		std::vector<uint32_t>	m_index;
+		size_t					m_current;
+		bool					m_failed;
+	};
+
+#endif
+
+	/**
+	 * Returns position of the first '"', '\' or control character at or after 'processed', or 'length' if there is none.
+	 * With UTF8_VALIDATE non-ASCII bytes are returned as well.
+	 */
+	static inline uint32_t FindStringSpecial(const char* parseBuffer, uint32_t processed, uint32_t length, Utf8Policy utf8Policy) {
+#if defined(AJSON_SSE2)
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i space = _mm_set1_epi8(0x20);
+		const __m128i minusOne = _mm_set1_epi8(-1);
+
+		while(length - processed >= 16) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&parseBuffer[processed]));
+			__m128i control = _mm_and_si128(_mm_cmpgt_epi8(space, v), _mm_cmpgt_epi8(v, minusOne));
+			__m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)), control);
+			if(utf8Policy == UTF8_VALIDATE) {
+				// Sign bit of non-ASCII bytes
+				match = _mm_or_si128(match, v);
+			}
+			uint32_t bits = _mm_movemask_epi8(match);
+			if(bits != 0) {
+				return processed + TrailingZeros(bits);
+			}
+			processed += 16;
+		}
+#endif
+		while(processed != length) {
+			uint8_t c = parseBuffer[processed];
+			if(c == '"' || c == '\\' || c < 0x20 || (c >= 0x80 && utf8Policy == UTF8_VALIDATE)) {
 				break;
+			}
+			processed++;
+		}
+
+		return processed;
+	}
+
+	static void ParseString(const char* parseBuffer, JsonToken& token, uint32_t& processed, uint32_t length, Utf8Policy utf8Policy) {
+		uint32_t stringStart = processed;
+		processed++;
+		while(true)
+		{
+			processed = FindStringSpecial(parseBuffer, processed, length, utf8Policy);
+
+			if(processed == length)
+			{
+				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unterminated string:", stringStart));
+			}
+
+			if(static_cast<uint8_t>(parseBuffer[processed]) >= 0x80)
+			{
+				uint32_t size = Utf8SequenceLength(parseBuffer, processed, length);
+				if(size == 0)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Invalid UTF-8 in string:", processed));
+				}
+				processed += size;
+				continue;
+			}
+
+			if(parseBuffer[processed] == '"')
+			{
+				token.set(JSON_STRING, stringStart, processed - stringStart - 1);
+				processed++;
+				return;
+			}
+
+			if(parseBuffer[processed] == '\\')
+			{
+				if(processed + 2 >= length)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unterminated string:", processed + 1));
+				}
+				if(parseBuffer[processed + 1] == 'f' || parseBuffer[processed + 1] == 'n' || parseBuffer[processed + 1] == 'r' || parseBuffer[processed + 1] == 't' || parseBuffer[processed + 1] == 'b' || parseBuffer[processed + 1] == '\\' || parseBuffer[processed + 1] == '/' || parseBuffer[processed + 1] == '"')
+				{
+					processed += 2;
+				} else if(parseBuffer[processed + 1] == 'u')
+				{
+					if(processed + 6 >= length)
+					{
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data when parsing hexadecimal escape sequence:", processed + 1));
+					}
+					if(!IsHex16(&parseBuffer[processed + 2]) || !IsHex16(&parseBuffer[processed + 4]))
+					{
+						throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Escape sequence is not hexadecimal:", processed + 1));
+					}
+					processed += 6;
+				} else
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unrecognized escape sequence", processed));
+				}
+			} else
+			{
+				throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unescaped control character in string:", processed));
+			}
+		}
+	}
+
+	/**
+	 * Reads the next token starting at 'processed', skipping any whitespace before it.
+	 * Returns false if the end of data is reached before a token is found.
+	 */
+	static bool ReadToken(const char* parseBuffer, JsonToken& token, uint32_t& processed, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+		while(processed != length)
+		{
+			switch(parseBuffer[processed])
+			{
+			case '{':
+				token.set(JSON_OBJ_BEGIN, processed);
+				processed++;
+				return true;
+			case '}':
+				token.set(JSON_OBJ_END, processed);
+				processed++;
+				return true;
+			case '[':
+				token.set(JSON_ARR_BEGIN, processed);
+				processed++;
+				return true;
+			case ']':
+				token.set(JSON_ARR_END, processed);
+				processed++;
+				return true;
+			case ',':
+				token.set(JSON_VALUE_SEP, processed);
+				processed++;
+				return true;
+			case ':':
+				token.set(JSON_NAME_SEP, processed);
+				processed++;
+				return true;
+			case '"':
+				ParseString(parseBuffer, token, processed, length, utf8Policy);
+				return true;
+			case 't':
+				if(processed + 4 > length)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data:", length));
+				}
+				if(parseBuffer[processed + 1] != 'r' || parseBuffer[processed + 2] != 'u' || parseBuffer[processed + 3] != 'e')
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting 'true':", processed));
+				}
+				token.set(JSON_TRUE, processed, 4);
+				processed += 4;
+				return true;
+			case 'f':
+				if(processed + 5 > length)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data:", length));
+				}
+				if(parseBuffer[processed + 1] != 'a' || parseBuffer[processed + 2] != 'l' || parseBuffer[processed + 3] != 's' || parseBuffer[processed + 4] != 'e')
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting 'false':", processed));
+				}
+				token.set(JSON_FALSE, processed, 5);
+				processed += 5;
+				return true;
+			case 'n':
+				if(processed + 4 > length)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected end of data:", length));
+				}
+				if(parseBuffer[processed + 1] != 'u' || parseBuffer[processed + 2] != 'l' || parseBuffer[processed + 3] != 'l')
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting 'null':", processed));
+				}
+				token.set(JSON_NULL, processed, 4);
+				processed += 4;
+				return true;
+			case 'b':
+				ParseBlob(parseBuffer, token, processed, length);
+				return true;
 			case '0':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '1':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '2':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '3':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '4':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '5':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '6':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '7':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '8':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '9':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
 			case '-':
-				ParseNumber(parseBuffer, tokens, processed, length);
-				break;
+				ParseNumber(parseBuffer, token, processed, length);
+				return true;
 			case ' ':
+			case '\n':
+			case '\r':
+			case '\t':
+			case '\f':
 				processed++;
 				break;
-			case '\n':
-				processed++;
+			case '/':
+				// Comment
+				if(commentPolicy == NO_COMMENTS) {
+					throw Exception(PARSER_ERROR, ComposeUnexpectedTokenMsg(parseBuffer, length, processed));
+				}
+
+				ParseComment(parseBuffer, token, processed, length, utf8Policy);
+				return true;
+			default:
+				throw Exception(PARSER_ERROR, ComposeUnexpectedTokenMsg(parseBuffer, length, processed));
+			}
+		}
+
+		return false;
+	}
+
+#if defined(AJSON_SIMD)
+	static inline bool IsTokenDelimiter(char c) {
+		switch(c)
+		{
+		case '{':
+		case '}':
+		case '[':
+		case ']':
+		case ',':
+		case ':':
+		case '"':
+		case '/':
+		case ' ':
+		case '\n':
+		case '\r':
+		case '\t':
+		case '\f':
+			return true;
+		default:
+			return false;
+		}
+	}
+#endif
+
+	/**
+	 * Produces tokens one at a time using the structural index to jump from token to token.
+	 * If the indexer stops, the rest of the input is tokenized by the scalar path.
+	 */
+	class TokenReader
+	{
+	public:
+#if defined(AJSON_SIMD)
+		TokenReader(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy = UTF8_UNCHECKED) : m_indexer(parseBuffer, length, utf8Policy) {
+			m_scalar = false;
+#else
+		TokenReader(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+			m_scalar = true;
+#endif
+			m_buffer = parseBuffer;
+			m_length = length;
+			m_processed = 0;
+			m_commentPolicy = commentPolicy;
+			m_utf8Policy = utf8Policy;
+		}
+
+		/**
+		 * Reads the next token.
+		 * Returns false at the end of data.
+		 */
+		bool Next(JsonToken& token) {
+			if(m_scalar) {
+				return ReadToken(m_buffer, token, m_processed, m_length, m_commentPolicy, m_utf8Policy);
+			}
+
+#if defined(AJSON_SIMD)
+			uint32_t position;
+			do {
+				if(!m_indexer.Next(position)) {
+					return SwitchToScalar(token);
+				}
+			} while(position < m_processed);
+
+			if(m_buffer[position] == '"') {
+				uint32_t closingQuote;
+				if(!m_indexer.Next(closingQuote)) {
+					m_processed = position;
+					return SwitchToScalar(token);
+				}
+
+				if(memchr(&m_buffer[position + 1], '\\', closingQuote - position - 1) != nullptr) {
+					// Escape sequences have to be validated
+					m_processed = position;
+					ParseString(m_buffer, token, m_processed, m_length, m_utf8Policy);
+				} else {
+					token.set(JSON_STRING, position, closingQuote - position - 1);
+					m_processed = closingQuote + 1;
+				}
+
+				return true;
+			}
+
+			m_processed = position;
+			ReadToken(m_buffer, token, m_processed, m_length, m_commentPolicy, m_utf8Policy);
+
+			// Literals are indexed by their first character only, the rest of the run must have been consumed
+			if(token.type >= JSON_INT && token.type <= JSON_BLOB && m_processed != m_length && !IsTokenDelimiter(m_buffer[m_processed])) {
+				throw Exception(PARSER_ERROR, ComposeUnexpectedTokenMsg(m_buffer, m_length, m_processed));
+			}
+
+			return true;
+#else
+			return false;
+#endif
+		}
+
+	private:
+#if defined(AJSON_SIMD)
+		bool SwitchToScalar(JsonToken& token) {
+			if(!m_indexer.Failed()) {
+				// End of data
+				return false;
+			}
+
+			m_scalar = true;
+			return ReadToken(m_buffer, token, m_processed, m_length, m_commentPolicy, m_utf8Policy);
+		}
+
+		StructuralIndexer	m_indexer;
+#endif
+		const char*			m_buffer;
+		uint32_t			m_length;
+		uint32_t			m_processed;
+		CommentPolicy		m_commentPolicy;
+		Utf8Policy			m_utf8Policy;
+		bool				m_scalar;
+	};
+
+	static void ParseTokens(std::vector<JsonToken>& tokens, const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+		TokenReader reader(parseBuffer, length, commentPolicy, utf8Policy);
+		JsonToken token;
+
+		while(reader.Next(token))
+		{
+			tokens.push_back(token);
+		}
+	}
+
+	/**
+	 * Root nodes are allocated from the document when parsing into one.
+	 */
+	static Node* CreateRootNode(Document* document, NodeType type) {
+		if(document != nullptr) {
+			return document->CreateRoot(type);
+		}
+		return new Node(type);
+	}
+
+	static Node* ParseJsonTokenized(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy, Document* document) {
+		std::vector<JsonToken> tokens;
+		ParseTokens(tokens, parseBuffer, length, commentPolicy, utf8Policy);
+
+		if(tokens.size() == 0)
+		{
+			return nullptr;
+		}
+
+		uint32_t currentToken = 1;
+
+		Node* rootNode;
+
+		if(tokens[0].type == JSON_OBJ_BEGIN)
+		{
+			rootNode = CreateRootNode(document, OBJECT_T);
+		} else if(tokens[0].type == JSON_ARR_BEGIN)
+		{
+			rootNode = CreateRootNode(document, ARRAY_T);
+		} else
+		{
+			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting '{' or '[':", tokens[0].location));
+		}
+
+		try {
+			ParseJsonNode(tokens, currentToken, rootNode, parseBuffer, length, commentPolicy);
+		} catch(Exception e) {
+			if(document == nullptr) {
+				delete rootNode;
+			}
+			throw e;
+		}
+
+		return rootNode;
+	}
+
+	/**
+	 * What the single pass parser expects next inside the container on top of its stack.
+	 */
+	enum ParseState : char
+	{
+		EXPECT_FIRST_MEMBER,	// After '{', node name or '}'
+		EXPECT_MEMBER,			// After ',' in an object, node name
+		EXPECT_NAME_SEP,		// After node name, ':'
+		EXPECT_MEMBER_VALUE,	// After ':', value
+		EXPECT_FIRST_ELEMENT,	// After '[', value or ']'
+		EXPECT_ELEMENT,			// After ',' in an array, value
+		EXPECT_SEP_OR_END		// After value, ',' or end of container
+	};
+
+	struct ParseFrame
+	{
+		uint64_t		location;
+		enum ParseState	state;
+		bool			object;
+	};
+
+	/**
+	 * Validates the token stream and reports it to 'handler' as events, one token at a time so the token list is never stored.
+	 * Containers are tracked on an explicit stack instead of recursion. Comments are only reported with ACCEPT_COMMENTS.
+	 * The input can be given in several windows that each end on a token boundary, token locations are relative to
+	 * their window and frame locations are relative to the start of the input.
+	 */
+	template<class Handler>
+	class EventParser
+	{
+	public:
+		EventParser(Handler& handler, CommentPolicy commentPolicy, Utf8Policy utf8Policy = UTF8_UNCHECKED) : m_handler(handler) {
+			m_commentPolicy = commentPolicy;
+			m_utf8Policy = utf8Policy;
+			m_rootParsed = false;
+			m_buffer = nullptr;
+			m_length = 0;
+			m_base = 0;
+		}
+
+		/**
+		 * Parses all tokens of the window, 'base' is the offset of the window in the input.
+		 */
+		void Parse(const char* parseBuffer, uint32_t length, uint64_t base = 0) {
+			SetWindow(parseBuffer, length, base);
+
+			TokenReader reader(parseBuffer, length, m_commentPolicy, m_utf8Policy);
+			JsonToken token;
+
+			while(reader.Next(token))
+			{
+				Token(token);
+			}
+		}
+
+		/**
+		 * Sets the window of tokens that are passed one by one to Token().
+		 */
+		void SetWindow(const char* parseBuffer, uint32_t length, uint64_t base = 0) {
+			m_buffer = parseBuffer;
+			m_length = length;
+			m_base = base;
+		}
+
+		/**
+		 * Throws if the input ended inside a container. Errors refer to the last window, which must still be valid.
+		 */
+		void Finish() {
+			if(!m_stack.empty())
+			{
+				if(m_stack.back().object)
+				{
+					throw Exception(PARSER_ERROR, ComposeError("Unterminated Object, expected '}'", m_stack.back().location));
+				} else
+				{
+					throw Exception(PARSER_ERROR, ComposeError("Unterminated Array, expected ']'", m_stack.back().location));
+				}
+			}
+		}
+
+		/**
+		 * Continues after a ',' between the elements of a root array that was opened before the input.
+		 * The handler has to be inside the array already.
+		 */
+		void ResumeArray(uint64_t location) {
+			ParseFrame frame;
+			frame.location = location;
+			frame.state = EXPECT_ELEMENT;
+			frame.object = false;
+			m_stack.push_back(frame);
+			m_rootParsed = true;
+		}
+
+		/**
+		 * True if the input so far ended right after an element of the root array.
+		 */
+		bool AfterRootElement() const {
+			return m_stack.size() == 1 && !m_stack.back().object && m_stack.back().state == EXPECT_SEP_OR_END;
+		}
+
+	private:
+		std::string ComposeError(const std::string& msg, uint64_t location) {
+			if(location >= m_base && location - m_base < m_length) {
+				return ComposeErrorMsg(m_buffer, m_length, msg, static_cast<uint32_t>(location - m_base));
+			}
+
+			// The window holding the location is gone
+			return msg + " At offset " + std::to_string(location) + ".\n";
+		}
+
+	public:
+		void Token(const JsonToken& token) {
+			const char* parseBuffer = m_buffer;
+			uint32_t length = m_length;
+
+			if(token.type == JSON_COMMENT)
+			{
+				if(m_commentPolicy == ACCEPT_COMMENTS)
+				{
+					m_handler.Comment(&parseBuffer[token.location + 2], token.size - 4);
+				}
+				return;
+			}
+
+			if(m_stack.empty())
+			{
+				if(m_rootParsed)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after end of root node:", token.location));
+				}
+
+				ParseFrame frame;
+				frame.location = m_base + token.location;
+				if(token.type == JSON_OBJ_BEGIN)
+				{
+					frame.state = EXPECT_FIRST_MEMBER;
+					frame.object = true;
+					m_handler.StartObject();
+				} else if(token.type == JSON_ARR_BEGIN)
+				{
+					frame.state = EXPECT_FIRST_ELEMENT;
+					frame.object = false;
+					m_handler.StartArray();
+				} else
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting '{' or '[':", token.location));
+				}
+				m_rootParsed = true;
+				m_stack.push_back(frame);
+				return;
+			}
+
+			ParseFrame& frame = m_stack.back();
+
+			switch(frame.state)
+			{
+			case EXPECT_FIRST_MEMBER:
+				if(token.type == JSON_OBJ_END)
+				{
+					m_stack.pop_back();
+					m_handler.EndObject();
+					break;
+				}
+				if(token.type != JSON_STRING)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting node name:", token.location));
+				}
+				frame.state = EXPECT_NAME_SEP;
+				m_handler.Key(&parseBuffer[token.location + 1], token.size);
+				break;
+			case EXPECT_MEMBER:
+				if(token.type != JSON_STRING)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after ',', was expecting node name:", token.location));
+				}
+				frame.state = EXPECT_NAME_SEP;
+				m_handler.Key(&parseBuffer[token.location + 1], token.size);
+				break;
+			case EXPECT_NAME_SEP:
+				if(token.type != JSON_NAME_SEP)
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after node name, was expecting ':':", token.location));
+				}
+				frame.state = EXPECT_MEMBER_VALUE;
+				break;
+			case EXPECT_FIRST_ELEMENT:
+				if(token.type == JSON_ARR_END)
+				{
+					m_stack.pop_back();
+					m_handler.EndArray();
+					break;
+				}
+				// Fall through - anything else must be a value
+			case EXPECT_ELEMENT:
+			case EXPECT_MEMBER_VALUE:
+				frame.state = EXPECT_SEP_OR_END;
+
+				if(token.type == JSON_OBJ_BEGIN || token.type == JSON_ARR_BEGIN)
+				{
+					ParseFrame child;
+					child.location = m_base + token.location;
+					child.object = token.type == JSON_OBJ_BEGIN;
+					child.state = child.object ? EXPECT_FIRST_MEMBER : EXPECT_FIRST_ELEMENT;
+					// 'frame' is invalidated here
+					m_stack.push_back(child);
+
+					if(child.object)
+					{
+						m_handler.StartObject();
+					} else
+					{
+						m_handler.StartArray();
+					}
+				} else if(token.type == JSON_STRING)
+				{
+					m_handler.String(&parseBuffer[token.location + 1], token.size);
+				} else if(token.type == JSON_INT)
+				{
+					m_handler.Int(token.value.intValue);
+				} else if(token.type == JSON_FLOAT)
+				{
+					m_handler.Float(token.value.floatValue);
+				} else if(token.type == JSON_TRUE)
+				{
+					m_handler.Bool(true);
+				} else if(token.type == JSON_FALSE)
+				{
+					m_handler.Bool(false);
+				} else if(token.type == JSON_NULL)
+				{
+					m_handler.Null();
+				} else if(token.type == JSON_BLOB)
+				{
+					// Decoded by handlers that need the value
+					m_handler.Blob(&parseBuffer[token.location], token.size);
+				} else
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token, was expecting value:", token.location));
+				}
+				break;
+			case EXPECT_SEP_OR_END:
+				if(token.type == JSON_VALUE_SEP)
+				{
+					frame.state = frame.object ? EXPECT_MEMBER : EXPECT_ELEMENT;
+				} else if(token.type == JSON_OBJ_END && frame.object)
+				{
+					m_stack.pop_back();
+					m_handler.EndObject();
+				} else if(token.type == JSON_ARR_END && !frame.object)
+				{
+					m_stack.pop_back();
+					m_handler.EndArray();
+				} else
+				{
+					throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, length, "Unexpected token after value, was expecting ',':", token.location));
+				}
+				break;
+			}
+		}
+
+	private:
+		Handler&				m_handler;
+		std::vector<ParseFrame>	m_stack;
+		const char*				m_buffer;
+		uint32_t				m_length;
+		uint64_t				m_base;
+		CommentPolicy			m_commentPolicy;
+		Utf8Policy				m_utf8Policy;
+		bool					m_rootParsed;
+	};
+
+	template<class Handler>
+	static void ParseJsonEvents(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Handler& handler, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+		EventParser<Handler> parser(handler, commentPolicy, utf8Policy);
+		parser.Parse(parseBuffer, length);
+		parser.Finish();
+	}
+
+	/**
+	 * Event handler of the single pass parser that builds the node tree.
+	 */
+	class NodeBuilder
+	{
+	public:
+		NodeBuilder(Document* document) {
+			m_document = document;
+			m_root = nullptr;
+		}
+
+		~NodeBuilder() {
+			// Root is only still owned here if parsing threw
+			if(m_root != nullptr && m_document == nullptr) {
+				delete m_root;
+			}
+		}
+
+		Node* Release() {
+			Node* root = m_root;
+			m_root = nullptr;
+			return root;
+		}
+
+		void StartObject() {
+			m_stack.push_back(Create(OBJECT_T));
+		}
+
+		void EndObject() {
+			m_stack.pop_back();
+		}
+
+		void StartArray() {
+			m_stack.push_back(Create(ARRAY_T));
+		}
+
+		void EndArray() {
+			m_stack.pop_back();
+		}
+
+		void Key(const char* data, uint32_t size) {
+			EscapeString(data, size, m_name);
+		}
+
+		void String(const char* data, uint32_t size) {
+			EscapeString(data, size, m_value);
+			m_stack.back()->CreateString(m_value, m_name);
+			m_name.clear();
+		}
+
+		void Int(int64_t value) {
+			if(m_stack.back()->IsArray()) {
+				m_stack.back()->AppendInt64(value);
+				return;
+			}
+			m_stack.back()->CreateInt64(value, m_name);
+			m_name.clear();
+		}
+
+		void Float(double value) {
+			if(m_stack.back()->IsArray()) {
+				m_stack.back()->AppendDouble(value);
+				return;
+			}
+			m_stack.back()->CreateDouble(value, m_name);
+			m_name.clear();
+		}
+
+		void Bool(bool value) {
+			if(m_stack.back()->IsArray()) {
+				m_stack.back()->AppendBool(value);
+				return;
+			}
+			m_stack.back()->CreateBool(value, m_name);
+			m_name.clear();
+		}
+
+		void Null() {
+			m_stack.back()->CreateNull(m_name);
+			m_name.clear();
+		}
+
+		void Blob(const char* data, uint32_t size) {
+			std::vector<uint8_t> blob;
+			ParseBlobString(data, size, blob);
+			m_stack.back()->CreateBlob(std::move(blob), m_name);
+			m_name.clear();
+		}
+
+		void Comment(const char* data, uint32_t size) {
+			// Comments outside of the root node have nowhere to go
+			if(m_stack.empty() == false) {
+				m_stack.back()->CreateComment(std::string(data, size));
+			}
+		}
+
+	private:
+		Node* Create(NodeType type) {
+			if(m_stack.empty()) {
+				m_root = CreateRootNode(m_document, type);
+				return m_root;
+			}
+
+			Node* node = m_stack.back()->CreateChild(type, m_name);
+			m_name.clear();
+			return node;
+		}
+
+		Document*			m_document;
+		Node*				m_root;
+		std::vector<Node*>	m_stack;
+		std::string			m_name;
+		std::string			m_value;
+	};
+
+	static Node* ParseJsonSinglePass(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy, Document* document) {
+		NodeBuilder builder(document);
+		ParseJsonEvents(parseBuffer, length, commentPolicy, builder, utf8Policy);
+
+		return builder.Release();
+	}
+
+	/**
+	 * Paths of a projection compiled into a tree, entry 0 is the document root.
+	 */
+	class ProjectionTree
+	{
+	public:
+		struct Segment
+		{
+			std::string				name;
+			uint32_t				index;		// Array index if name is a number
+			bool					wildcard;
+			bool					terminal;	// Complete subtree is wanted
+			std::vector<uint32_t>	children;
+		};
+
+		const static uint32_t NoIndex = UINT32_MAX;
+
+		ProjectionTree(const std::vector<std::string>& paths) {
+			m_segments.resize(1);
+			m_segments[0].index = NoIndex;
+			m_segments[0].wildcard = false;
+			m_segments[0].terminal = false;
+
+			for(size_t i = 0;i < paths.size();i++) {
+				AddPath(paths[i]);
+			}
+		}
+
+		const Segment& operator[](uint32_t n) const {
+			return m_segments[n];
+		}
+
+	private:
+		/**
+		 * Paths starting with '/' are JSON Pointers, others are separated by dots.
+		 */
+		void AddPath(const std::string& path) {
+			uint32_t current = 0;
+			bool pointer = !path.empty() && path[0] == '/';
+			char separator = pointer ? '/' : '.';
+			size_t start = pointer ? 1 : 0;
+
+			if(path.empty() || path == "/") {
+				m_segments[0].terminal = true;
+				return;
+			}
+
+			while(true) {
+				size_t end = path.find(separator, start);
+				if(end == std::string::npos) {
+					end = path.size();
+				}
+
+				std::string name = path.substr(start, end - start);
+				if(pointer) {
+					// ~1 is '/', ~0 is '~'
+					std::string unescaped;
+					for(size_t i = 0;i < name.size();i++) {
+						if(name[i] == '~' && i + 1 < name.size() && (name[i + 1] == '0' || name[i + 1] == '1')) {
+							unescaped += name[i + 1] == '0' ? '~' : '/';
+							i++;
+						} else {
+							unescaped += name[i];
+						}
+					}
+					name = unescaped;
+				}
+
+				current = AddSegment(current, name);
+
+				if(end == path.size()) {
+					break;
+				}
+				start = end + 1;
+			}
+
+			m_segments[current].terminal = true;
+		}
+
+		uint32_t AddSegment(uint32_t parent, const std::string& name) {
+			for(size_t i = 0;i < m_segments[parent].children.size();i++) {
+				uint32_t child = m_segments[parent].children[i];
+				if(m_segments[child].name == name) {
+					return child;
+				}
+			}
+
+			Segment segment;
+			segment.name = name;
+			segment.wildcard = name == "*";
+			segment.terminal = false;
+			segment.index = NoIndex;
+
+			if(!name.empty() && name.size() <= 9 && name.find_first_not_of("0123456789") == std::string::npos) {
+				segment.index = static_cast<uint32_t>(strtoul(name.c_str(), nullptr, 10));
+			}
+
+			uint32_t id = static_cast<uint32_t>(m_segments.size());
+			m_segments.push_back(segment);
+			m_segments[parent].children.push_back(id);
+			return id;
+		}
+
+		std::vector<Segment> m_segments;
+	};
+
+	/**
+	 * Event handler of the single pass parser that only builds nodes for projected paths and their ancestors.
+	 * Matched values are built completely, ancestors are created when the first value below them matches.
+	 */
+	class ProjectionBuilder
+	{
+	public:
+		ProjectionBuilder(const ProjectionTree& tree, Document* document) : m_tree(tree) {
+			m_document = document;
+			m_root = nullptr;
+			m_skipDepth = 0;
+		}
+
+		~ProjectionBuilder() {
+			// Root is only still owned here if parsing threw
+			if(m_root != nullptr && m_document == nullptr) {
+				delete m_root;
+			}
+		}
+
+		Node* Release() {
+			Node* root = m_root;
+			m_root = nullptr;
+			return root;
+		}
+
+		void StartObject() {
+			StartContainer(OBJECT_T);
+		}
+
+		void EndObject() {
+			EndContainer();
+		}
+
+		void StartArray() {
+			StartContainer(ARRAY_T);
+		}
+
+		void EndArray() {
+			EndContainer();
+		}
+
+		void Key(const char* data, uint32_t size) {
+			if(m_skipDepth == 0) {
+				EscapeString(data, size, m_name);
+			}
+		}
+
+		void String(const char* data, uint32_t size) {
+			Node* parent = Target();
+			if(parent != nullptr) {
+				EscapeString(data, size, m_value);
+				parent->CreateString(m_value, m_name);
+			}
+			m_name.clear();
+		}
+
+		void Int(int64_t value) {
+			Node* parent = Target();
+			if(parent != nullptr && parent->IsArray()) {
+				parent->AppendInt64(value);
+			} else if(parent != nullptr) {
+				parent->CreateInt64(value, m_name);
+			}
+			m_name.clear();
+		}
+
+		void Float(double value) {
+			Node* parent = Target();
+			if(parent != nullptr && parent->IsArray()) {
+				parent->AppendDouble(value);
+			} else if(parent != nullptr) {
+				parent->CreateDouble(value, m_name);
+			}
+			m_name.clear();
+		}
+
+		void Bool(bool value) {
+			Node* parent = Target();
+			if(parent != nullptr && parent->IsArray()) {
+				parent->AppendBool(value);
+			} else if(parent != nullptr) {
+				parent->CreateBool(value, m_name);
+			}
+			m_name.clear();
+		}
+
+		void Null() {
+			Node* parent = Target();
+			if(parent != nullptr) {
+				parent->CreateNull(m_name);
+			}
+			m_name.clear();
+		}
+
+		void Blob(const char* data, uint32_t size) {
+			Node* parent = Target();
+			if(parent != nullptr) {
+				std::vector<uint8_t> blob;
+				ParseBlobString(data, size, blob);
+				parent->CreateBlob(std::move(blob), m_name);
+			}
+			m_name.clear();
+		}
+
+		void Comment(const char* data, uint32_t size) {
+			// Only comments inside of matched values are kept
+			if(m_skipDepth == 0 && !m_captured.empty()) {
+				m_captured.back()->CreateComment(std::string(data, size));
+			}
+		}
+
+	private:
+		/**
+		 * Container on the projected path, its node is only created when something below it matches.
+		 */
+		struct Frame
+		{
+			Node*					node;
+			std::string				name;
+			NodeType				type;
+			uint32_t				index;	// Of the next array element
+			std::vector<uint32_t>	segments;
+		};
+
+		/**
+		 * Matches the next value against the segments of the innermost frame.
+		 * Returns 1 if the value is wanted completely, 0 if not at all and -1 if only part of it might be.
+		 */
+		int Match(std::vector<uint32_t>& matched) {
+			Frame& frame = m_frames.back();
+			uint32_t index = frame.index;
+			if(frame.type == ARRAY_T) {
+				frame.index++;
+			}
+
+			matched.clear();
+			for(size_t i = 0;i < frame.segments.size();i++) {
+				const ProjectionTree::Segment& segment = m_tree[frame.segments[i]];
+				for(size_t j = 0;j < segment.children.size();j++) {
+					const ProjectionTree::Segment& child = m_tree[segment.children[j]];
+					bool match = child.wildcard || (frame.type == OBJECT_T ? child.name == m_name : child.index == index);
+					if(match) {
+						if(child.terminal) {
+							return 1;
+						}
+						matched.push_back(segment.children[j]);
+					}
+				}
+			}
+
+			return matched.empty() ? 0 : -1;
+		}
+
+		/**
+		 * Creates the nodes of frame n and of its ancestors.
+		 */
+		Node* Materialize(size_t n) {
+			if(m_frames[n].node == nullptr) {
+				m_frames[n].node = Materialize(n - 1)->CreateChild(m_frames[n].type, m_frames[n].name);
+			}
+			return m_frames[n].node;
+		}
+
+		/**
+		 * Parent node for the next scalar, nullptr if it isn't wanted.
+		 */
+		Node* Target() {
+			if(m_skipDepth != 0) {
+				return nullptr;
+			}
+
+			if(!m_captured.empty()) {
+				return m_captured.back();
+			}
+
+			if(Match(m_matched) != 1) {
+				return nullptr;
+			}
+
+			return Materialize(m_frames.size() - 1);
+		}
+
+		void StartContainer(NodeType type) {
+			if(m_skipDepth != 0) {
+				m_skipDepth++;
+				return;
+			}
+
+			if(!m_captured.empty()) {
+				m_captured.push_back(m_captured.back()->CreateChild(type, m_name));
+				m_name.clear();
+				return;
+			}
+
+			if(m_frames.empty() && m_root == nullptr) {
+				m_root = CreateRootNode(m_document, type);
+				if(m_tree[0].terminal) {
+					m_captured.push_back(m_root);
+					return;
+				}
+
+				Frame frame;
+				frame.node = m_root;
+				frame.type = type;
+				frame.index = 0;
+				frame.segments.push_back(0);
+				m_frames.push_back(frame);
+				return;
+			}
+
+			int match = Match(m_matched);
+			if(match == 1) {
+				m_captured.push_back(Materialize(m_frames.size() - 1)->CreateChild(type, m_name));
+			} else if(match == 0) {
+				m_skipDepth = 1;
+			} else {
+				Frame frame;
+				frame.node = nullptr;
+				frame.name = m_name;
+				frame.type = type;
+				frame.index = 0;
+				frame.segments.swap(m_matched);
+				m_frames.push_back(frame);
+			}
+			m_name.clear();
+		}
+
+		void EndContainer() {
+			if(m_skipDepth != 0) {
+				m_skipDepth--;
+			} else if(!m_captured.empty()) {
+				m_captured.pop_back();
+			} else {
+				m_frames.pop_back();
+			}
+		}
+
+		const ProjectionTree&	m_tree;
+		Document*				m_document;
+		Node*					m_root;
+		std::vector<Frame>		m_frames;
+		std::vector<Node*>		m_captured;
+		std::vector<uint32_t>	m_matched;
+		std::string				m_name;
+		std::string				m_value;
+		uint32_t				m_skipDepth;
+	};
+
+	static Node* ParseJsonProjected(const char* parseBuffer, size_t length, const std::vector<std::string>& paths, CommentPolicy commentPolicy, Document* document) {
+		if(length > UINT32_MAX) {
+			throw Exception(PARSER_ERROR, "Input larger than 4 GiB is not supported.\n");
+		}
+
+		ProjectionTree tree(paths);
+		ProjectionBuilder builder(tree, document);
+		ParseJsonEvents(parseBuffer, static_cast<uint32_t>(length), commentPolicy, builder);
+
+		return builder.Release();
+	}
+
+	/**
+	 * Forwards events of the single pass parser to a user handler.
+	 */
+	class HandlerAdapter
+	{
+	public:
+		HandlerAdapter(JsonHandler& handler) : m_handler(handler) {}
+
+		void StartObject() { m_handler.StartObject(); }
+		void EndObject() { m_handler.EndObject(); }
+		void StartArray() { m_handler.StartArray(); }
+		void EndArray() { m_handler.EndArray(); }
+		void Key(const char* data, uint32_t size) {
+			if(memchr(data, '\\', size) == nullptr) {
+				m_handler.Key(data, size);
+			} else {
+				EscapeString(data, size, m_buffer);
+				m_handler.Key(m_buffer.data(), static_cast<uint32_t>(m_buffer.size()));
+			}
+		}
+
+		void String(const char* data, uint32_t size) {
+			if(memchr(data, '\\', size) == nullptr) {
+				m_handler.String(data, size);
+			} else {
+				EscapeString(data, size, m_buffer);
+				m_handler.String(m_buffer.data(), static_cast<uint32_t>(m_buffer.size()));
+			}
+		}
+
+		void Int(int64_t value) { m_handler.Int(value); }
+		void Float(double value) { m_handler.Float(value); }
+		void Bool(bool value) { m_handler.Bool(value); }
+		void Null() { m_handler.Null(); }
+		void Blob(const char* data, uint32_t size) {
+			std::vector<uint8_t> blob;
+			ParseBlobString(data, size, blob);
+			m_handler.Blob(blob);
+		}
+		void Comment(const char* data, uint32_t size) { m_handler.Comment(data, size); }
+
+	private:
+		JsonHandler&	m_handler;
+		std::string		m_buffer;	// Decoded strings with escape sequences
+	};
+
+	/**
+	 * Finds the ',' between elements of a root array that split it into up to 'parts' ranges of similar size.
+	 * Only a quick structural scan, the ranges are validated when they are parsed. The scan stops at comments
+	 * and invalid strings, the rest of the array then stays in the last range.
+	 */
+	std::vector<uint32_t> FindArraySplits(const char* parseBuffer, uint32_t length, uint32_t parts) {
+		std::vector<uint32_t> splits;
+		uint32_t step = length / parts;
+		uint32_t next = step;
+		uint32_t depth = 0;
+
+#if defined(AJSON_SIMD)
+		StructuralIndexer indexer(parseBuffer, length, UTF8_UNCHECKED);
+		uint32_t position;
+
+		while(splits.size() + 1 < parts && indexer.Next(position)) {
+			char c = parseBuffer[position];
+
+			if(depth == 0 && c != '[') {
+				break;
+			}
+
+			if(c == '[' || c == '{') {
+				depth++;
+			} else if(c == ']' || c == '}') {
+				if(--depth == 0) {
+					break;
+				}
+			} else if(c == ',' && depth == 1 && position >= next) {
+				splits.push_back(position);
+				next = position + step;
+			}
+		}
+#else
+		for(uint32_t position = 0;position < length && splits.size() + 1 < parts;position++) {
+			char c = parseBuffer[position];
+
+			if(c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f') {
+				continue;
+			}
+
+			if(depth == 0 && c != '[') {
+				break;
+			}
+
+			if(c == '"') {
+				// Skip to the closing quote
+				position = FindStringSpecial(parseBuffer, position + 1, length, UTF8_UNCHECKED);
+				while(position + 1 < length && parseBuffer[position] == '\\') {
+					position = FindStringSpecial(parseBuffer, position + 2, length, UTF8_UNCHECKED);
+				}
+				if(position >= length || parseBuffer[position] != '"') {
+					break;
+				}
+			} else if(c == '[' || c == '{') {
+				depth++;
+			} else if(c == ']' || c == '}') {
+				if(--depth == 0) {
+					break;
+				}
+			} else if(c == ',' && depth == 1 && position >= next) {
+				splits.push_back(position);
+				next = position + step;
+			} else if(c == '/') {
+				break;
+			}
+		}
+#endif
+
+		return splits;
+	}
+
+	/**
+	 * Parses a large root array on several threads. The array is split at ',' between its elements, each range
+	 * is parsed into a detached array and their children are spliced into the first one in order.
+	 * Errors are reported by parsing again on one thread, which also covers splits the quick scan got wrong.
+	 */
+	class ArrayParser
+	{
+	public:
+		ArrayParser(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+			m_buffer = parseBuffer;
+			m_length = length;
+			m_commentPolicy = commentPolicy;
+			m_utf8Policy = utf8Policy;
+		}
+
+		~ArrayParser() {
+			for(size_t i = 0;i < m_ranges.size();i++) {
+				delete m_ranges[i].array;
+			}
+		}
+
+		/**
+		 * Returns nullptr if the input is not a root array that can be split into more than one range.
+		 */
+		Node* Parse(uint32_t threads) {
+			uint32_t parts = std::min<uint32_t>(threads, m_length / MinRangeSize);
+			if(parts < 2) {
+				return nullptr;
+			}
+
+			std::vector<uint32_t> splits = FindArraySplits(m_buffer, m_length, parts);
+			if(splits.empty()) {
+				return nullptr;
+			}
+
+			uint32_t begin = 0;
+			for(size_t i = 0;i <= splits.size();i++) {
+				Range range;
+				range.begin = begin;
+				range.end = i < splits.size() ? splits[i] : m_length;
+				range.array = nullptr;
+				m_ranges.push_back(range);
+
+				begin = range.end + 1;
+			}
+
+			// The calling thread takes the first range
+			std::vector<std::thread> workers;
+			workers.reserve(m_ranges.size());
+			for(size_t i = 1;i < m_ranges.size();i++) {
+				try {
+					workers.push_back(std::thread(&ArrayParser::ParseRange, this, i));
+				} catch(std::system_error&) {
+					// Out of threads
+					ParseRange(i);
+				}
+			}
+			ParseRange(0);
+
+			for(size_t i = 0;i < workers.size();i++) {
+				workers[i].join();
+			}
+
+			for(size_t i = 0;i < m_ranges.size();i++) {
+				if(m_ranges[i].array == nullptr) {
+					return ParseJsonSinglePass(m_buffer, m_length, m_commentPolicy, m_utf8Policy, nullptr);
+				}
+			}
+
+			Node* root = m_ranges[0].array;
+			for(size_t i = 1;i < m_ranges.size();i++) {
+				root->SpliceChildren(m_ranges[i].array);
+			}
+			m_ranges[0].array = nullptr;
+
+			return root;
+		}
+
+	private:
+		const static uint32_t MinRangeSize = 1 << 20;
+
+		struct Range
+		{
+			uint32_t	begin;
+			uint32_t	end;
+			Node*		array;		// nullptr if parsing failed
+		};
+
+		void ParseRange(size_t index) {
+			Range& range = m_ranges[index];
+			bool first = index == 0;
+			bool last = index + 1 == m_ranges.size();
+
+			try {
+				NodeBuilder builder(nullptr);
+				EventParser<NodeBuilder> parser(builder, m_commentPolicy, m_utf8Policy);
+
+				if(!first) {
+					builder.StartArray();
+					parser.ResumeArray(range.begin);
+				}
+
+				parser.Parse(&m_buffer[range.begin], range.end - range.begin, range.begin);
+
+				if(last) {
+					parser.Finish();
+				} else if(!parser.AfterRootElement()) {
+					return;
+				}
+
+				range.array = builder.Release();
+			} catch(...) {
+				// Reported by the single threaded parse
+			}
+		}
+
+		const char*			m_buffer;
+		uint32_t			m_length;
+		CommentPolicy		m_commentPolicy;
+		Utf8Policy			m_utf8Policy;
+		std::vector<Range>	m_ranges;
+	};
+
+	Node* ParseJsonParallel(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy, uint32_t threads) {
+		ArrayParser parser(parseBuffer, length, commentPolicy, utf8Policy);
+		Node* root = parser.Parse(threads);
+
+		if(root == nullptr) {
+			return ParseJsonSinglePass(parseBuffer, length, commentPolicy, utf8Policy, nullptr);
+		}
+
+		return root;
+	}
+
+	/**
+	 * Parses without writing to or copying the input, 'document' is nullptr for heap allocated nodes.
+	 */
+	static Node* ParseJsonBuffer(const char* parseBuffer, size_t length, CommentPolicy commentPolicy, ParseMode parseMode, Utf8Policy utf8Policy, Document* document) {
+		if(length > UINT32_MAX) {
+			throw Exception(PARSER_ERROR, "Input larger than 4 GiB is not supported.\n");
+		}
+
+		if(parseMode == PARSE_PARALLEL && document == nullptr)
+		{
+			return ParseJsonParallel(parseBuffer, static_cast<uint32_t>(length), commentPolicy, utf8Policy, std::thread::hardware_concurrency());
+		} else if(parseMode == PARSE_TOKENIZED)
+		{
+			return ParseJsonTokenized(parseBuffer, static_cast<uint32_t>(length), commentPolicy, utf8Policy, document);
+		} else
+		{
+			return ParseJsonSinglePass(parseBuffer, static_cast<uint32_t>(length), commentPolicy, utf8Policy, document);
+		}
+	}
+
+	static void ReadJsonFile(const std::string& filename, std::string& parseBuffer) {
+		FILE* fp = fopen(filename.c_str(), "rb");
+		if(fp == nullptr)
+		{
+			std::string errorString = "Could not read from file '" + filename + "'.\n";
+			throw Exception(IO_ERROR, errorString);
+		}
+
+		fseek(fp, 0, SEEK_END);
+		long length = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+
+		if(length > 0) {
+			parseBuffer.resize(length);
+			parseBuffer.resize(fread(&parseBuffer[0], 1, length, fp));
+		}
+
+		fclose(fp);
+	}
+
+	/**
+	 * Read only view of a whole file. Maps the file where the platform supports it,
+	 * otherwise (or if mapping fails) reads it into memory.
+	 */
+	class FileView {
+	public:
+		FileView(const std::string& filename, FileLoad fileLoad) {
+			m_data = nullptr;
+			m_size = 0;
+			m_mapping = nullptr;
+
+#if defined(AJSON_MMAP)
+			if(fileLoad != LOAD_READ) {
+				int fd = open(filename.c_str(), O_RDONLY);
+				if(fd == -1) {
+					std::string errorString = "Could not read from file '" + filename + "'.\n";
+					throw Exception(IO_ERROR, errorString);
+				}
+
+				struct stat st;
+				if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+					if(st.st_size == 0) {
+						close(fd);
+						return;
+					}
+
+					int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+					if(fileLoad == LOAD_MAPPED_POPULATE) {
+						flags |= MAP_POPULATE;
+					}
+#endif
+					void* mapping = mmap(nullptr, st.st_size, PROT_READ, flags, fd, 0);
+					if(mapping != MAP_FAILED) {
+#if defined(MADV_SEQUENTIAL)
+						madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+#endif
+						m_mapping = mapping;
+						m_data = static_cast<const char*>(mapping);
+						m_size = st.st_size;
+					}
+				}
+
+				close(fd);
+				if(m_mapping != nullptr) {
+					return;
+				}
+			}
+#else
+			(void)fileLoad;
+#endif
+
+			ReadJsonFile(filename, m_buffer);
+			m_data = m_buffer.data();
+			m_size = m_buffer.size();
+		}
+
+		~FileView() {
+#if defined(AJSON_MMAP)
+			if(m_mapping != nullptr) {
+				munmap(m_mapping, m_size);
+			}
+#endif
+		}
+
+		const char* Data() const {
+			return m_data;
+		}
+
+		size_t Size() const {
+			return m_size;
+		}
+	private:
+		FileView(const FileView&) = delete;
+		FileView& operator=(const FileView&) = delete;
+
+		const char*	m_data;
+		size_t		m_size;
+		void*		m_mapping;
+		std::string	m_buffer;
+	};
+
+	Node* ParseJson(const char* data, size_t length, CommentPolicy commentPolicy, ParseMode parseMode, Utf8Policy utf8Policy) {
+		return ParseJsonBuffer(data, length, commentPolicy, parseMode, utf8Policy, nullptr);
+	}
+
+	Node* ParseJson(const std::string& parseBuffer, CommentPolicy commentPolicy, ParseMode parseMode, Utf8Policy utf8Policy) {
+		return ParseJsonBuffer(parseBuffer.data(), parseBuffer.size(), commentPolicy, parseMode, utf8Policy, nullptr);
+	}
+
+	Node* ParseJson(const char* data, size_t length, const std::vector<std::string>& paths, CommentPolicy commentPolicy) {
+		return ParseJsonProjected(data, length, paths, commentPolicy, nullptr);
+	}
+
+	Node* ParseJson(const std::string& parseBuffer, const std::vector<std::string>& paths, CommentPolicy commentPolicy) {
+		return ParseJsonProjected(parseBuffer.data(), parseBuffer.size(), paths, commentPolicy, nullptr);
+	}
+
+	Node* ParseJsonFile(const std::string& filename, CommentPolicy commentPolicy, ParseMode parseMode, FileLoad fileLoad, Utf8Policy utf8Policy) {
+		FileView file(filename, fileLoad);
+
+		return ParseJsonBuffer(file.Data(), file.Size(), commentPolicy, parseMode, utf8Policy, nullptr);
+	}
+
+	void ParseJson(const char* data, size_t length, JsonHandler& handler, CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+		if(length > UINT32_MAX) {
+			throw Exception(PARSER_ERROR, "Input larger than 4 GiB is not supported.\n");
+		}
+
+		HandlerAdapter adapter(handler);
+		ParseJsonEvents(data, static_cast<uint32_t>(length), commentPolicy, adapter, utf8Policy);
+	}
+
+	void ParseJson(const std::string& parseBuffer, JsonHandler& handler, CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+		ParseJson(parseBuffer.data(), parseBuffer.size(), handler, commentPolicy, utf8Policy);
+	}
+
+	void ParseJsonFile(const std::string& filename, JsonHandler& handler, CommentPolicy commentPolicy, FileLoad fileLoad, Utf8Policy utf8Policy) {
+		FileView file(filename, fileLoad);
+
+		ParseJson(file.Data(), file.Size(), handler, commentPolicy, utf8Policy);
+	}
+
+	/**
+	 * Lines of a json lines input that are parsed by one worker.
+	 */
+	struct LinesChunk
+	{
+		const char*			data;
+		size_t				length;
+		std::vector<Node*>	records;
+		uint64_t			lines;		// Parsed lines, including the failed one
+		std::string			error;
+		bool				failed;
+		bool				done;
+	};
+
+	/**
+	 * Parses the chunks of a json lines input on worker threads, the calling thread delivers the records in order.
+	 * Workers only run a few chunks ahead of delivery, so memory is bounded independent of the input size.
+	 */
+	class LinesParser
+	{
+	public:
+		LinesParser(const char* data, size_t length, CommentPolicy commentPolicy, uint32_t threads, Utf8Policy utf8Policy) {
+			m_commentPolicy = commentPolicy;
+			m_utf8Policy = utf8Policy;
+			m_next = 0;
+			m_delivered = 0;
+			m_stop = false;
+
+			size_t start = 0;
+			while(start < length) {
+				size_t end = length - start > ChunkSize ? start + ChunkSize : length;
+				const char* newline = static_cast<const char*>(memchr(&data[end - 1], '\n', length - end + 1));
+				end = newline != nullptr ? newline - data + 1 : length;
+
+				LinesChunk chunk;
+				chunk.data = &data[start];
+				chunk.length = end - start;
+				chunk.lines = 0;
+				chunk.failed = false;
+				chunk.done = false;
+				m_chunks.push_back(chunk);
+
+				start = end;
+			}
+
+			if(threads == 0) {
+				threads = std::thread::hardware_concurrency();
+			}
+			if(threads > m_chunks.size()) {
+				threads = static_cast<uint32_t>(m_chunks.size());
+			}
+			if(threads == 0) {
+				threads = 1;
+			}
+			m_window = threads * 4;
+
+			// The destructor doesn't run if the constructor throws, stop the workers that did start
+			try {
+				for(uint32_t i = 0;i < threads;i++) {
+					m_workers.push_back(std::thread(&LinesParser::Work, this));
+				}
+			} catch(...) {
+				Stop();
+				throw;
+			}
+		}
+
+		~LinesParser() {
+			Stop();
+
+			// Records that were never delivered
+			for(size_t i = m_delivered;i < m_chunks.size();i++) {
+				for(size_t j = 0;j < m_chunks[i].records.size();j++) {
+					delete m_chunks[i].records[j];
+				}
+			}
+		}
+
+		void Deliver(const std::function<void(Node*)>& callback) {
+			uint64_t line = 0;
+
+			while(m_delivered < m_chunks.size()) {
+				LinesChunk& chunk = m_chunks[m_delivered];
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					while(!chunk.done) {
+						m_condition.wait(lock);
+					}
+				}
+
+				for(size_t i = 0;i < chunk.records.size();i++) {
+					Node* record = chunk.records[i];
+					// The callback owns the record even if it throws
+					chunk.records[i] = nullptr;
+					callback(record);
+				}
+
+				if(chunk.failed) {
+					throw Exception(PARSER_ERROR, "Record at line " + std::to_string(line + chunk.lines) + ": " + chunk.error);
+				}
+
+				line += chunk.lines;
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_delivered++;
+				}
+				m_condition.notify_all();
+			}
+		}
+
+	private:
+		const static size_t ChunkSize = 1 << 20;
+
+		void Stop() {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_stop = true;
+			}
+			m_condition.notify_all();
+
+			for(size_t i = 0;i < m_workers.size();i++) {
+				m_workers[i].join();
+			}
+			m_workers.clear();
+		}
+
+		void Work() {
+			while(true) {
+				size_t index;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					while(!m_stop && m_next < m_chunks.size() && m_next >= m_delivered + m_window) {
+						m_condition.wait(lock);
+					}
+					if(m_stop || m_next == m_chunks.size()) {
+						return;
+					}
+					index = m_next++;
+				}
+
+				Parse(m_chunks[index]);
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_chunks[index].done = true;
+				}
+				m_condition.notify_all();
+			}
+		}
+
+		void Parse(LinesChunk& chunk) {
+			size_t start = 0;
+			while(start < chunk.length) {
+				const char* newline = static_cast<const char*>(memchr(&chunk.data[start], '\n', chunk.length - start));
+				size_t end = newline != nullptr ? newline - chunk.data : chunk.length;
+				chunk.lines++;
+
+				try {
+					if(end - start > UINT32_MAX) {
+						throw Exception(PARSER_ERROR, "Input larger than 4 GiB is not supported.\n");
+					}
+
+					// Blank lines give no root node
+					Node* record = ParseJsonSinglePass(&chunk.data[start], static_cast<uint32_t>(end - start), m_commentPolicy, m_utf8Policy, nullptr);
+					if(record != nullptr) {
+						chunk.records.push_back(record);
+					}
+				} catch(Exception& e) {
+					chunk.failed = true;
+					chunk.error = e.what();
+					return;
+				} catch(std::bad_alloc&) {
+					chunk.failed = true;
+					chunk.error = "Out of memory.\n";
+					return;
+				}
+
+				start = end + 1;
+			}
+		}
+
+		std::vector<LinesChunk>		m_chunks;
+		std::vector<std::thread>	m_workers;
+		std::mutex					m_mutex;
+		std::condition_variable		m_condition;
+		size_t						m_next;
+		size_t						m_delivered;
+		size_t						m_window;
+		CommentPolicy				m_commentPolicy;
+		Utf8Policy					m_utf8Policy;
+		bool						m_stop;
+	};
+
+	void ParseJsonLines(const char* data, size_t length, const std::function<void(Node*)>& callback, CommentPolicy commentPolicy, uint32_t threads, Utf8Policy utf8Policy) {
+		LinesParser parser(data, length, commentPolicy, threads, utf8Policy);
+		parser.Deliver(callback);
+	}
+
+	std::vector<Node*> ParseJsonLines(const char* data, size_t length, CommentPolicy commentPolicy, uint32_t threads, Utf8Policy utf8Policy) {
+		std::vector<Node*> records;
+
+		try {
+			ParseJsonLines(data, length, [&records](Node* record) {
+				records.push_back(record);
+			}, commentPolicy, threads, utf8Policy);
+		} catch(...) {
+			for(size_t i = 0;i < records.size();i++) {
+				delete records[i];
+			}
+			throw;
+		}
+
+		return records;
+	}
+
+	std::vector<Node*> ParseJsonLines(const std::string& parseBuffer, CommentPolicy commentPolicy, uint32_t threads, Utf8Policy utf8Policy) {
+		return ParseJsonLines(parseBuffer.data(), parseBuffer.size(), commentPolicy, threads, utf8Policy);
+	}
+
+	void ParseJsonLinesFile(const std::string& filename, const std::function<void(Node*)>& callback, CommentPolicy commentPolicy, uint32_t threads, FileLoad fileLoad, Utf8Policy utf8Policy) {
+		FileView file(filename, fileLoad);
+
+		ParseJsonLines(file.Data(), file.Size(), callback, commentPolicy, threads, utf8Policy);
+	}
+
+	std::vector<Node*> ParseJsonLinesFile(const std::string& filename, CommentPolicy commentPolicy, uint32_t threads, FileLoad fileLoad, Utf8Policy utf8Policy) {
+		FileView file(filename, fileLoad);
+
+		return ParseJsonLines(file.Data(), file.Size(), commentPolicy, threads, utf8Policy);
+	}
+
+	/**
+	 * Event handler that ignores all events, for validation only.
+	 */
+	class NullHandler
+	{
+	public:
+		void StartObject() {}
+		void EndObject() {}
+		void StartArray() {}
+		void EndArray() {}
+		void Key(const char* /*data*/, uint32_t /*size*/) {}
+		void String(const char* /*data*/, uint32_t /*size*/) {}
+		void Int(int64_t /*value*/) {}
+		void Float(double /*value*/) {}
+		void Bool(bool /*value*/) {}
+		void Null() {}
+		void Blob(const char* /*data*/, uint32_t /*size*/) {}
+		void Comment(const char* /*data*/, uint32_t /*size*/) {}
+	};
+
+	bool Validate(const char* data, size_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy, std::string* error) {
+		try {
+			if(length > UINT32_MAX) {
+				throw Exception(PARSER_ERROR, "Input larger than 4 GiB is not supported.\n");
+			}
+
+			NullHandler handler;
+			ParseJsonEvents(data, static_cast<uint32_t>(length), commentPolicy, handler, utf8Policy);
+		} catch(Exception& e) {
+			if(error != nullptr) {
+				*error = e.what();
+			}
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Validate(const std::string& parseBuffer, CommentPolicy commentPolicy, Utf8Policy utf8Policy, std::string* error) {
+		return Validate(parseBuffer.data(), parseBuffer.size(), commentPolicy, utf8Policy, error);
+	}
+
+	LazyDocument::LazyDocument(const char* data, size_t length, CommentPolicy commentPolicy) {
+		if(length > UINT32_MAX) {
+			throw Exception(PARSER_ERROR, "Input larger than 4 GiB is not supported.\n");
+		}
+
+		m_data = data;
+		m_length = static_cast<uint32_t>(length);
+		m_root = NoLocation;
+		m_commentPolicy = commentPolicy;
+
+		// Validate everything once and record where each container ends, so navigation can jump over them
+		NullHandler handler;
+		EventParser<NullHandler> parser(handler, commentPolicy);
+		parser.SetWindow(m_data, m_length);
+
+		TokenReader reader(m_data, m_length, commentPolicy);
+		JsonToken token;
+		std::vector<uint32_t> open;
+
+		while(reader.Next(token))
+		{
+			parser.Token(token);
+
+			if(token.type == JSON_OBJ_BEGIN || token.type == JSON_ARR_BEGIN)
+			{
+				if(m_root == NoLocation)
+				{
+					m_root = token.location;
+				}
+				open.push_back(static_cast<uint32_t>(m_spans.size()));
+				m_spans.push_back(Span{token.location, 0});
+			} else if(token.type == JSON_OBJ_END || token.type == JSON_ARR_END)
+			{
+				m_spans[open.back()].end = token.location;
+				open.pop_back();
+			}
+		}
+
+		parser.Finish();
+	}
+
+	LazyValue LazyDocument::GetRoot() const {
+		if(m_root == NoLocation) {
+			return LazyValue();
+		}
+
+		return LazyValue(this, m_root, NoLocation);
+	}
+
+	bool LazyDocument::Next(uint32_t& location, JsonToken& token) const {
+		do {
+			if(!ReadToken(m_data, token, location, m_length, m_commentPolicy, UTF8_UNCHECKED)) {
+				return false;
+			}
+		} while(token.type == JSON_COMMENT);
+
+		return true;
+	}
+
+	uint32_t LazyDocument::Skip(uint32_t location) const {
+		if(m_data[location] == '{' || m_data[location] == '[') {
+			// Spans are ordered by their beginning
+			std::vector<Span>::const_iterator it = std::lower_bound(m_spans.begin(), m_spans.end(), location, [](const Span& span, uint32_t begin) {
+				return span.begin < begin;
+			});
+			return it->end + 1;
+		}
+
+		JsonToken token;
+		Next(location, token);
+		return location;
+	}
+
+	bool LazyDocument::Step(uint32_t& location, bool object, JsonToken& name, JsonToken& value) const {
+		Next(location, value);
+		if(value.type == JSON_VALUE_SEP) {
+			Next(location, value);
+		}
+
+		if(value.type == JSON_OBJ_END || value.type == JSON_ARR_END) {
+			return false;
+		}
+
+		if(object) {
+			name = value;
+
+			JsonToken separator;
+			Next(location, separator);
+			Next(location, value);
+		}
+
+		if(value.type == JSON_OBJ_BEGIN || value.type == JSON_ARR_BEGIN) {
+			location = Skip(value.location);
+		}
+
+		return true;
+	}
+
+	NodeType LazyValue::GetType() const {
+		if(m_document == nullptr) {
+			return NULL_T;
+		}
+
+		switch(m_document->m_data[m_location])
+		{
+		case '{':
+			return OBJECT_T;
+		case '[':
+			return ARRAY_T;
+		case '"':
+			return STRING_T;
+		case 't':
+		case 'f':
+			return BOOL_T;
+		case 'n':
+			return NULL_T;
+		case 'b':
+			return BLOB_T;
+		default:
+			{
+				JsonToken token;
+				uint32_t location = m_location;
+				m_document->Next(location, token);
+				return token.type == JSON_INT ? INT_T : FLOAT_T;
+			}
+		}
+	}
+
+	std::string LazyValue::GetName() const {
+		if(m_document == nullptr || m_nameLocation == LazyDocument::NoLocation) {
+			return std::string("");
+		}
+
+		JsonToken token;
+		uint32_t location = m_nameLocation;
+		m_document->Next(location, token);
+		return TokenString(m_document->m_data, token);
+	}
+
+	uint32_t LazyValue::Children() const {
+		NodeType type = GetType();
+		if(type != OBJECT_T && type != ARRAY_T) {
+			return 0;
+		}
+
+		uint32_t count = 0;
+		uint32_t location = m_location + 1;
+		JsonToken name, value;
+		while(m_document->Step(location, type == OBJECT_T, name, value)) {
+			count++;
+		}
+
+		return count;
+	}
+
+	LazyValue LazyValue::GetChild(uint32_t n) const {
+		NodeType type = GetType();
+		if(type != OBJECT_T && type != ARRAY_T) {
+			return LazyValue();
+		}
+
+		uint32_t location = m_location + 1;
+		JsonToken name, value;
+		for(uint32_t i = 0;m_document->Step(location, type == OBJECT_T, name, value);i++) {
+			if(i == n) {
+				return LazyValue(m_document, value.location, type == OBJECT_T ? name.location : LazyDocument::NoLocation);
+			}
+		}
+
+		return LazyValue();
+	}
+
+	LazyValue LazyValue::GetChild(const std::string& name) const {
+		if(GetType() != OBJECT_T) {
+			return LazyValue();
+		}
+
+		const char* data = m_document->m_data;
+		uint32_t location = m_location + 1;
+		JsonToken nameToken, value;
+		LazyValue found;
+		std::string decoded;
+
+		// Last member wins on duplicate names, same as Node
+		while(m_document->Step(location, true, nameToken, value)) {
+			const char* key = &data[nameToken.location + 1];
+			bool match;
+
+			if(memchr(key, '\\', nameToken.size) == nullptr) {
+				match = nameToken.size == name.size() && memcmp(key, name.data(), name.size()) == 0;
+			} else {
+				EscapeString(key, nameToken.size, decoded);
+				match = decoded == name;
+			}
+
+			if(match) {
+				found = LazyValue(m_document, value.location, nameToken.location);
+			}
+		}
+
+		return found;
+	}
+
+	LazyValue LazyValue::FirstChild() const {
+		return GetChild(0u);
+	}
+
+	LazyValue LazyValue::NextSibling() const {
+		if(m_document == nullptr || m_location == m_document->m_root) {
+			return LazyValue();
+		}
+
+		bool object = m_nameLocation != LazyDocument::NoLocation;
+		uint32_t location = m_document->Skip(m_location);
+		JsonToken name, value;
+		if(!m_document->Step(location, object, name, value)) {
+			return LazyValue();
+		}
+
+		return LazyValue(m_document, value.location, object ? name.location : LazyDocument::NoLocation);
+	}
+
+	/**
+	 * Reads the scalar token of a lazy value, leaves 'token' as JSON_NULL for invalid values and containers.
+	 */
+	static void ReadLazyValue(const char* data, uint32_t length, uint32_t location, bool valid, JsonToken& token) {
+		token.type = JSON_NULL;
+		if(!valid || data[location] == '{' || data[location] == '[') {
+			return;
+		}
+
+		ReadToken(data, token, location, length, IGNORE_COMMENTS, UTF8_UNCHECKED);
+	}
+
+	int32_t LazyValue::GetInt() const {
+		return static_cast<int32_t>(GetInt64());
+	}
+
+	int64_t LazyValue::GetInt64() const {
+		JsonToken token;
+		ReadLazyValue(m_document ? m_document->m_data : nullptr, m_document ? m_document->m_length : 0, m_location, m_document != nullptr, token);
+		if(token.type == JSON_INT) {
+			return token.value.intValue;
+		} else if(token.type == JSON_FLOAT) {
+			return static_cast<int64_t>(token.value.floatValue);
+		} else {
+			return 0;
+		}
+	}
+
+	float LazyValue::GetFloat() const {
+		return static_cast<float>(GetDouble());
+	}
+
+	double LazyValue::GetDouble() const {
+		JsonToken token;
+		ReadLazyValue(m_document ? m_document->m_data : nullptr, m_document ? m_document->m_length : 0, m_location, m_document != nullptr, token);
+		if(token.type == JSON_FLOAT) {
+			return token.value.floatValue;
+		} else if(token.type == JSON_INT) {
+			return static_cast<double>(token.value.intValue);
+		} else {
+			return 0.0;
+		}
+	}
+
+	bool LazyValue::GetBool() const {
+		return m_document != nullptr && m_document->m_data[m_location] == 't';
+	}
+
+	std::string LazyValue::GetString() const {
+		JsonToken token;
+		ReadLazyValue(m_document ? m_document->m_data : nullptr, m_document ? m_document->m_length : 0, m_location, m_document != nullptr, token);
+		if(token.type == JSON_STRING) {
+			return TokenString(m_document->m_data, token);
+		} else {
+			return std::string("");
+		}
+	}
+
+	std::vector<uint8_t> LazyValue::GetBlob() const {
+		JsonToken token;
+		std::vector<uint8_t> blob;
+		ReadLazyValue(m_document ? m_document->m_data : nullptr, m_document ? m_document->m_length : 0, m_location, m_document != nullptr, token);
+		if(token.type == JSON_BLOB) {
+			ParseBlobString(&m_document->m_data[token.location], token.size, blob);
+		}
+
+		return blob;
+	}
+
+	Node* LazyValue::Materialize() const {
+		if(m_document == nullptr) {
+			return nullptr;
+		}
+
+		Node* node;
+		switch(GetType())
+		{
+		case OBJECT_T:
+		case ARRAY_T:
+			{
+				uint32_t end = m_document->Skip(m_location);
+				node = ParseJsonSinglePass(&m_document->m_data[m_location], end - m_location, m_document->m_commentPolicy, UTF8_UNCHECKED, nullptr);
+			}
+			break;
+		case STRING_T:
+			node = new Node(GetString());
+			break;
+		case INT_T:
+			node = new Node(GetInt64());
+			break;
+		case FLOAT_T:
+			node = new Node(GetDouble());
+			break;
+		case BOOL_T:
+			node = new Node(GetBool());
+			break;
+		case BLOB_T:
+			node = new Node(GetBlob());
+			break;
+		default:
+			node = new Node(NULL_T);
+			break;
+		}
+
+		node->SetName(GetName());
+		return node;
+	}
+
+	/**
+	 * Lexical state at the end of the input fed to a PushParser so far.
+	 */
+	enum ScanState : char
+	{
+		SCAN_TOKENS,		// Between or inside literal tokens
+		SCAN_SLASH,			// After '/'
+		SCAN_STRING,		// Inside string or blob
+		SCAN_ESCAPE,		// After '\\' inside string
+		SCAN_COMMENT,		// Inside comment
+		SCAN_COMMENT_STAR	// After '*' inside comment
+	};
+
+	class PushParser::State
+	{
+	public:
+		State(Document* document) {
+			m_document = document;
+			m_consumed = 0;
+			m_lines = 0;
+			m_column = 0;
+			m_scanState = SCAN_TOKENS;
+			m_closed = false;
+		}
+
+		virtual ~State() {}
+
+		/**
+		 * Parses a window that ends on a token boundary, 'base' is its offset in the input.
+		 */
+		virtual void Parse(const char* data, uint32_t length, uint64_t base) = 0;
+		virtual Node* Finish() = 0;
+
+		/**
+		 * Moves past a window that was parsed, errors in the next window are located relative to its end.
+		 */
+		void Consume(const char* data, size_t length) {
+			m_consumed += length;
+
+			const char* end = data + length;
+			const char* lineStart = data;
+			const char* newline;
+			while((newline = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart))) != nullptr) {
+				m_lines++;
+				lineStart = newline + 1;
+			}
+
+			if(lineStart != data) {
+				m_column = end - lineStart;
+			} else {
+				m_column += length;
+			}
+		}
+
+		Document*	m_document;
+		std::string	m_pending;
+		uint64_t	m_consumed;
+		uint64_t	m_lines;		// Lines consumed
+		uint64_t	m_column;		// Bytes consumed since the last line break
+		ScanState	m_scanState;
+		bool		m_closed;
+	};
+
+	static Node* ReleaseRoot(NodeBuilder& builder) {
+		return builder.Release();
+	}
+
+	static Node* ReleaseRoot(HandlerAdapter&) {
+		return nullptr;
+	}
+
+	template<class Handler>
+	class PushState : public PushParser::State
+	{
+	public:
+		template<class Target>
+		PushState(Target& target, Document* document, CommentPolicy commentPolicy, Utf8Policy utf8Policy) : State(document), m_handler(target), m_parser(m_handler, commentPolicy, utf8Policy) {}
+
+		void Parse(const char* data, uint32_t length, uint64_t base) {
+			m_parser.Parse(data, length, base);
+		}
+
+		Node* Finish() {
+			m_parser.Finish();
+			return ReleaseRoot(m_handler);
+		}
+
+	private:
+		Handler					m_handler;
+		EventParser<Handler>	m_parser;
+	};
+
+	PushParser::PushParser(CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+		Document* document = nullptr;
+		m_state = new PushState<NodeBuilder>(document, nullptr, commentPolicy, utf8Policy);
+	}
+
+	PushParser::PushParser(Document& document, CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+		document.Reset();
+		Document* target = &document;
+		m_state = new PushState<NodeBuilder>(target, &document, commentPolicy, utf8Policy);
+	}
+
+	PushParser::PushParser(JsonHandler& handler, CommentPolicy commentPolicy, Utf8Policy utf8Policy) {
+		m_state = new PushState<HandlerAdapter>(handler, nullptr, commentPolicy, utf8Policy);
+	}
+
+	PushParser::~PushParser() {
+		delete m_state;
+	}
+
+	void PushParser::Feed(const char* data, size_t length) {
+		State& state = *m_state;
+		if(state.m_closed) {
+			throw Exception(PARSER_ERROR, "PushParser can't be fed after Finish() or an error.\n");
+		}
+
+		// Find the first and last position after which everything fed so far forms complete tokens
+		size_t first = SIZE_MAX;
+		size_t last = SIZE_MAX;
+		ScanState scanState = state.m_scanState;
+
+		for(size_t i = 0;i < length;i++) {
+			char c = data[i];
+			switch(scanState)
+			{
+			case SCAN_SLASH:
+				if(c == '*') {
+					scanState = SCAN_COMMENT;
+					break;
+				}
+				scanState = SCAN_TOKENS;
+				// Fall through - the tokenizer reports the stray '/'
+			case SCAN_TOKENS:
+				switch(c)
+				{
+				case '{':
+				case '}':
+				case '[':
+				case ']':
+				case ',':
+				case ':':
+				case ' ':
+				case '\n':
+				case '\r':
+				case '\t':
+				case '\f':
+					if(first == SIZE_MAX) {
+						first = i + 1;
+					}
+					last = i + 1;
+					break;
+				case '"':
+					scanState = SCAN_STRING;
+					break;
+				case '/':
+					scanState = SCAN_SLASH;
+					break;
+				}
+				break;
+			case SCAN_STRING:
+				if(c == '\\') {
+					scanState = SCAN_ESCAPE;
+				} else if(c == '"') {
+					scanState = SCAN_TOKENS;
+				}
 				break;
-			case '\r':
-				processed++;
+			case SCAN_ESCAPE:
+				scanState = SCAN_STRING;
 				break;
-			case '\t':
-				processed++;
+			case SCAN_COMMENT:
+				if(c == '*') {
+					scanState = SCAN_COMMENT_STAR;
+				}
 				break;
-			case '\f':
-				processed++;
+			case SCAN_COMMENT_STAR:
+				if(c == '/') {
+					scanState = SCAN_TOKENS;
+					if(first == SIZE_MAX) {
+						first = i + 1;
+					}
+					last = i + 1;
+				} else if(c != '*') {
+					scanState = SCAN_COMMENT;
+				}
 				break;
-			case '/':
-				// Comment
-				if(commentPolicy == NO_COMMENTS) {
-					throw Exception(PARSER_ERROR, ComposeUnexpectedTokenMsg(parseBuffer, processed));
+			}
+		}
+
+		state.m_scanState = scanState;
+
+		try {
+			if(last == SIZE_MAX) {
+				// Still inside the same token
+				if(state.m_pending.size() + length > UINT32_MAX) {
+					throw Exception(PARSER_ERROR, "Tokens larger than 4 GiB are not supported.\n");
 				}
+				state.m_pending.append(data, length);
+				return;
+			}
 
-				ParseComment(parseBuffer, tokens, processed, length);
-				break;
-			default:
-				throw Exception(PARSER_ERROR, ComposeUnexpectedTokenMsg(parseBuffer, processed));
-				break;
+			if(last - first > UINT32_MAX || state.m_pending.size() + first > UINT32_MAX) {
+				throw Exception(PARSER_ERROR, "Chunks larger than 4 GiB are not supported.\n");
+			}
+
+			size_t start = 0;
+			if(!state.m_pending.empty()) {
+				// Complete the token that was split by the previous chunk
+				state.m_pending.append(data, first);
+				state.Parse(state.m_pending.data(), static_cast<uint32_t>(state.m_pending.size()), state.m_consumed);
+				state.Consume(state.m_pending.data(), state.m_pending.size());
+				state.m_pending.clear();
+				start = first;
 			}
+
+			if(last > start) {
+				state.Parse(&data[start], static_cast<uint32_t>(last - start), state.m_consumed);
+				state.Consume(&data[start], last - start);
+			}
+
+			state.m_pending.assign(&data[last], length - last);
+		} catch(Exception& e) {
+			Close();
+			e.m_errorString = ShiftErrorLocation(e.m_errorString, state.m_lines, state.m_column);
+			throw;
+		} catch(...) {
+			Close();
+			throw;
 		}
 	}
 
-	Node* ParseJson(const std::string& _parseBuffer, CommentPolicy commentPolicy) {
-		std::vector<JsonToken> tokens;
-		char* parseBuffer = const_cast<char*>(_parseBuffer.c_str());
-		ParseTokens(tokens, parseBuffer, commentPolicy);
-
-		if(tokens.size() == 0)
-		{
-			return nullptr;
+	Node* PushParser::Finish() {
+		State& state = *m_state;
+		if(state.m_closed) {
+			throw Exception(PARSER_ERROR, "PushParser can't be fed after Finish() or an error.\n");
 		}
 
-		uint32_t currentToken = 1;
+		Node* root;
+		try {
+			state.Parse(state.m_pending.data(), static_cast<uint32_t>(state.m_pending.size()), state.m_consumed);
+			root = state.Finish();
+		} catch(Exception& e) {
+			Close();
+			e.m_errorString = ShiftErrorLocation(e.m_errorString, state.m_lines, state.m_column);
+			throw;
+		} catch(...) {
+			Close();
+			throw;
+		}
 
-		Node* rootNode;
+		state.m_closed = true;
+		std::string().swap(state.m_pending);
+		return root;
+	}
 
-		if(tokens[0].type == JSON_OBJ_BEGIN)
-		{
-			rootNode = new Node(OBJECT_T);
-		} else if(tokens[0].type == JSON_ARR_BEGIN)
-		{
-			rootNode = new Node(ARRAY_T);
-		} else
-		{
-			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token, was expecting '{' or '[':", tokens[0].location));
+	void PushParser::Close() {
+		m_state->m_closed = true;
+		if(m_state->m_document != nullptr) {
+			m_state->m_document->Reset();
 		}
+	}
 
-		ParseJsonNode(tokens, currentToken, rootNode, parseBuffer, commentPolicy);
+	Node* Document::Parse(const char* data, size_t length, CommentPolicy commentPolicy, ParseMode parseMode, Utf8Policy utf8Policy) {
+		Reset();
 
-		//if(currentToken + 1 < tokens.size()) {
-		//	throw
-		//}
+		try {
+			ParseJsonBuffer(data, length, commentPolicy, parseMode, utf8Policy, this);
+		} catch(Exception e) {
+			Reset();
+			throw e;
+		}
 
-		return rootNode;
+		return m_root;
 	}
 
-	Node* ParseJsonFile(const std::string& filename, CommentPolicy commentPolicy) {
-		FILE* fp = fopen(filename.c_str(), "r");
-		if(fp == nullptr)
-		{
-			std::string errorString = "Could not read from file '" + filename + "'.\n";
-			throw Exception(IO_ERROR, errorString);
+	Node* Document::Parse(const std::string& parseBuffer, CommentPolicy commentPolicy, ParseMode parseMode, Utf8Policy utf8Policy) {
+		return Parse(parseBuffer.data(), parseBuffer.size(), commentPolicy, parseMode, utf8Policy);
+	}
+
+	Node* Document::Parse(const char* data, size_t length, const std::vector<std::string>& paths, CommentPolicy commentPolicy) {
+		Reset();
+
+		try {
+			ParseJsonProjected(data, length, paths, commentPolicy, this);
+		} catch(Exception e) {
+			Reset();
+			throw e;
 		}
 
-		fseek(fp, 0, SEEK_END);
-		size_t length = ftell(fp);
-		fseek(fp, 0, SEEK_SET);
+		return m_root;
+	}
 
-		char* parseBuffer = new char[length + 1];
-		parseBuffer[length] = '\0';
-		fread(parseBuffer, 1, length, fp);
+	Node* Document::Parse(const std::string& parseBuffer, const std::vector<std::string>& paths, CommentPolicy commentPolicy) {
+		return Parse(parseBuffer.data(), parseBuffer.size(), paths, commentPolicy);
+	}
 
-		fclose(fp);
+	Node* Document::ParseFile(const std::string& filename, CommentPolicy commentPolicy, ParseMode parseMode, FileLoad fileLoad, Utf8Policy utf8Policy) {
+		FileView file(filename, fileLoad);
 
-		std::vector<JsonToken> tokens;
-		ParseTokens(tokens, parseBuffer, commentPolicy);
+		return Parse(file.Data(), file.Size(), commentPolicy, parseMode, utf8Policy);
+	}
 
-		if(tokens.size() == 0)
-		{
-			return nullptr;
+	/**
+	 * Writes the shortest of 15, 16 or 17 significant digits that reads back as the same double.
+	 * The output always contains '.' or an exponent so it is parsed back as float.
+	 * Infinities and NaN have no json representation and are written as null.
+	 */
+	static void FormatFloat(double value, char* numBuffer, uint32_t size) {
+		if(!std::isfinite(value)) {
+			snprintf(numBuffer, size, "null");
+			return;
 		}
 
-		uint32_t currentToken = 1;
+		char decimalPoint = localeconv()->decimal_point[0];
 
-		Node* rootNode;
+		for(int precision = 15;precision <= 17;precision++) {
+			snprintf(numBuffer, size, "%.*g", precision, value);
+			if(strtod(numBuffer, nullptr) == value) {
+				break;
+			}
+		}
 
-		if(tokens[0].type == JSON_OBJ_BEGIN)
-		{
-			rootNode = new Node(OBJECT_T);
-		} else if(tokens[0].type == JSON_ARR_BEGIN)
-		{
-			rootNode = new Node(ARRAY_T);
-		} else
-		{
-			throw Exception(PARSER_ERROR, ComposeErrorMsg(parseBuffer, "Unexpected token, was expecting '{' or '[':", tokens[0].location));
+		if(decimalPoint != '.') {
+			char* dot = strchr(numBuffer, decimalPoint);
+			if(dot != nullptr) {
+				*dot = '.';
+			}
+		}
+
+		if(strpbrk(numBuffer, ".eE") == nullptr) {
+			strncat(numBuffer, ".0", size - strlen(numBuffer) - 1);
 		}
+	}
 
-		ParseJsonNode(tokens, currentToken, rootNode, parseBuffer, commentPolicy);
+	/**
+	 * Prints the elements of a packed array without turning them into nodes.
+	 */
+	static void PrintPacked(const Node& node, std::string& buf, uint32_t depth, const char* separator, const char* terminator) {
+		const uint32_t NumBufferSize = 64;
+		char numBuffer[NumBufferSize];
 
-		delete parseBuffer;
-		return rootNode;
+		uint32_t count = node.Children();
+		for(uint32_t i = 0;i < count;i++) {
+			buf.append(depth, '\t');
+
+			if(node.GetPackedType() == INT_T) {
+				snprintf(numBuffer, NumBufferSize, "%lld", static_cast<long long>(node.GetPackedInts()[i]));
+				buf += numBuffer;
+			} else if(node.GetPackedType() == FLOAT_T) {
+				FormatFloat(node.GetPackedDoubles()[i], numBuffer, NumBufferSize);
+				buf += numBuffer;
+			} else {
+				buf += node.GetPackedBools()[i] ? "true" : "false";
+			}
+
+			buf += i + 1 < count ? separator : terminator;
+		}
 	}
 
-	template <enum JsonOutput formatStyle> void PrintJson(const Node& node, std::string& buf, uint16_t depth, CommentPolicy commentPolicy);
+	template <enum JsonOutput formatStyle> void PrintJson(const Node& node, std::string& buf, uint32_t depth, CommentPolicy commentPolicy);
 
-	template<> void PrintJson<JSON_SPACED>(const Node& node, std::string& buf, uint16_t depth, CommentPolicy commentPolicy) {
+	template<> void PrintJson<JSON_SPACED>(const Node& node, std::string& buf, uint32_t depth, CommentPolicy commentPolicy) {
 		const char trueString[] = "true";
 		const char falseString[] = "false";
 		const char nullString[] = "null";
@@ -1943,18 +5562,18 @@ namespace ajson {
 		if(node.GetParent() != nullptr) {
 			if(node.GetParent()->GetType() == OBJECT_T)
 			{
-				for(uint16_t i = 0;i < depth;i++)
+				for(uint32_t i = 0;i < depth;i++)
 				{
 					buf += "\t";
 				}
 
 				if(node.GetType() != COMMENT_T) {
 					buf += "\"";
-					buf += DescapeString(node.GetName());
+					DescapeString(node.GetName(), buf);
 					buf += "\" : ";
 				}
 			} else {
-				for(uint16_t i = 0;i < depth;i++)
+				for(uint32_t i = 0;i < depth;i++)
 				{
 					buf += "\t";
 				}
@@ -1965,7 +5584,7 @@ namespace ajson {
 		{
 		case OBJECT_T:
 			buf += "{\n";
-			for(uint16_t i = 0;i < node.Children();i++)
+			for(uint32_t i = 0;i < node.Children();i++)
 			{
 				PrintJson<JSON_SPACED>(*node.GetChild(i), buf, depth + 1, commentPolicy);
 
@@ -1985,7 +5604,7 @@ namespace ajson {
 					}
 				}
 			}
-			for(uint16_t i = 0;i < depth;i++)
+			for(uint32_t i = 0;i < depth;i++)
 			{
 				buf += "\t";
 			}
@@ -1994,27 +5613,31 @@ namespace ajson {
 			break;
 		case ARRAY_T:
 			buf += "[\n";
-			for(uint16_t i = 0;i < node.Children();i++)
-			{
-				PrintJson<JSON_SPACED>(*node.GetChild(i), buf, depth + 1, commentPolicy);
+			if(node.IsPacked()) {
+				PrintPacked(node, buf, depth + 1, ",\n", "\n");
+			} else {
+				for(uint32_t i = 0;i < node.Children();i++)
+				{
+					PrintJson<JSON_SPACED>(*node.GetChild(i), buf, depth + 1, commentPolicy);
 
-				if(commentPolicy == ACCEPT_COMMENTS) {
-					if(i == (node.Children() - 1) || node.GetChild(i)->GetType() == COMMENT_T) {
-						buf += "\n";
-					} else {
-						buf += ",\n";
-					}
-				} else {
-					if(node.GetChild(i)->GetType() != COMMENT_T) {
-						if(i == (node.Children() - 1)) {
+					if(commentPolicy == ACCEPT_COMMENTS) {
+						if(i == (node.Children() - 1) || node.GetChild(i)->GetType() == COMMENT_T) {
 							buf += "\n";
 						} else {
 							buf += ",\n";
 						}
+					} else {
+						if(node.GetChild(i)->GetType() != COMMENT_T) {
+							if(i == (node.Children() - 1)) {
+								buf += "\n";
+							} else {
+								buf += ",\n";
+							}
+						}
 					}
 				}
 			}
-			for(uint16_t i = 0;i < depth;i++)
+			for(uint32_t i = 0;i < depth;i++)
 			{
 				buf += "\t";
 			}
@@ -2023,7 +5646,7 @@ namespace ajson {
 			break;
 		case STRING_T:
 			buf += "\"";
-			buf += DescapeString(node.GetString());
+			DescapeString(node.GetString(), buf);
 			buf += "\"";
 			break;
 		case COMMENT_T:
@@ -2032,35 +5655,12 @@ namespace ajson {
 			buf += "*/";
 			break;
 		case INT_T:
-			sprintf(numBuffer, "%i", node.GetInt());
+			snprintf(numBuffer, NumBufferSize, "%lld", static_cast<long long>(node.GetInt64()));
 			buf += numBuffer;
 			break;
 		case FLOAT_T:
-			{
-				sprintf(numBuffer, "%f", node.GetFloat());
-
-				uint32_t decimal = 0;
-				uint32_t lastNonZero = 0;
-
-				// Remove unnecessary zeros after decimal
-				for(uint32_t i = 0;i < NumBufferSize;i++) {
-					if(numBuffer[i] == '.') {
-						decimal = i + 1;
-						lastNonZero = decimal;
-						break;
-					}
-				}
-
-				for(uint32_t i = decimal;i < NumBufferSize;i++) {
-					if(numBuffer[i] > '0') {
-						lastNonZero = i;
-					}
-				}
-
-				numBuffer[lastNonZero + 1] = '\0';
-
-				buf += numBuffer;
-			}
+			FormatFloat(node.GetDouble(), numBuffer, NumBufferSize);
+			buf += numBuffer;
 			break;
 		case BOOL_T:
 			if(node.GetBool() == true) {
@@ -2079,7 +5679,7 @@ namespace ajson {
 		}
 	}
 
-	template<> void PrintJson<JSON_COMPACT>(const Node& node, std::string& buf, uint16_t depth, CommentPolicy commentPolicy) {
+	template<> void PrintJson<JSON_COMPACT>(const Node& node, std::string& buf, uint32_t depth, CommentPolicy commentPolicy) {
 		const char trueString[] = "true";
 		const char falseString[] = "false";
 		const char nullString[] = "null";
@@ -2102,7 +5702,7 @@ namespace ajson {
 			if(node.GetParent()->GetType() == OBJECT_T && node.GetType() != COMMENT_T)
 			{
 				buf += "\"";
-				buf += DescapeString(node.GetName());
+				DescapeString(node.GetName(), buf);
 				buf += "\":";
 			}
 		}
@@ -2111,7 +5711,7 @@ namespace ajson {
 		{
 		case OBJECT_T:
 			buf += "{";
-			for(uint16_t i = 0;i < node.Children();i++)
+			for(uint32_t i = 0;i < node.Children();i++)
 			{
 				PrintJson<JSON_COMPACT>(*node.GetChild(i), buf, 0, commentPolicy);
 
@@ -2124,12 +5724,16 @@ namespace ajson {
 			break;
 		case ARRAY_T:
 			buf += "[";
-			for(uint16_t i = 0;i < node.Children();i++)
-			{
-				PrintJson<JSON_COMPACT>(*node.GetChild(i), buf, 0, commentPolicy);
+			if(node.IsPacked()) {
+				PrintPacked(node, buf, 0, ",", "");
+			} else {
+				for(uint32_t i = 0;i < node.Children();i++)
+				{
+					PrintJson<JSON_COMPACT>(*node.GetChild(i), buf, 0, commentPolicy);
 
-				if(i != (node.Children() - 1) && node.GetChild(i)->GetType() != COMMENT_T) {
-					buf += ",";
+					if(i != (node.Children() - 1) && node.GetChild(i)->GetType() != COMMENT_T) {
+						buf += ",";
+					}
 				}
 			}
 
@@ -2137,7 +5741,7 @@ namespace ajson {
 			break;
 		case STRING_T:
 			buf += "\"";
-			buf += DescapeString(node.GetString());
+			DescapeString(node.GetString(), buf);
 			buf += "\"";
 			break;
 		case COMMENT_T:
@@ -2146,35 +5750,12 @@ namespace ajson {
 			buf += "*/";
 			break;
 		case INT_T:
-			sprintf(numBuffer, "%i", node.GetInt());
+			snprintf(numBuffer, NumBufferSize, "%lld", static_cast<long long>(node.GetInt64()));
 			buf += numBuffer;
 			break;
 		case FLOAT_T:
-			{
-				sprintf(numBuffer, "%f", node.GetFloat());
-
-				uint32_t decimal = 0;
-				uint32_t lastNonZero = 0;
-
-				// Remove unnecessary zeros after decimal
-				for(uint32_t i = 0;i < NumBufferSize;i++) {
-					if(numBuffer[i] == '.') {
-						decimal = i + 1;
-						lastNonZero = decimal;
-						break;
-					}
-				}
-
-				for(uint32_t i = decimal;i < NumBufferSize;i++) {
-					if(numBuffer[i] > '0') {
-						lastNonZero = i;
-					}
-				}
-
-				numBuffer[lastNonZero + 1] = '\0';
-
-				buf += numBuffer;
-			}
+			FormatFloat(node.GetDouble(), numBuffer, NumBufferSize);
+			buf += numBuffer;
 			break;
 		case BOOL_T:
 			if(node.GetBool() == true)
@@ -2251,14 +5832,15 @@ namespace ajson {
 
 	class BinaryReader {
 	public:
-		BinaryReader(BinaryBuffer* buffer) {
-			m_buffer = buffer;
+		BinaryReader(const char* data, uint32_t size) {
+			m_data = data;
+			m_size = size;
 			m_pointer = 0;
 			m_endianness = getEndianness();
 		}
 
 		~BinaryReader() {
-			m_buffer = nullptr;
+			m_data = nullptr;
 		}
 
 		enum class Endianness {
@@ -2287,21 +5869,21 @@ namespace ajson {
 	    }
 
 		bool readChar(char& value) {
-			if(m_pointer + 1 > m_buffer->Size()) {
+			if(m_pointer + 1 > m_size) {
 				return false;
 			}
 
-			value = m_buffer->Data()[m_pointer];
+			value = m_data[m_pointer];
 			m_pointer++;
 			return true;
 		}
 
 		bool readShort(int16_t& value) {
-			if(m_pointer + 2 > m_buffer->Size()) {
+			if(m_pointer + 2 > m_size) {
 				return false;
 			}
 
-			value = reinterpret_cast<int16_t *>(m_buffer->Data())[m_pointer];
+			memcpy(&value, &m_data[m_pointer], sizeof(value));
 			if(m_endianness == Endianness::Little) {
 				value = swap(value);
 			}
@@ -2310,11 +5892,11 @@ namespace ajson {
 		}
 
 		bool readInt(int32_t& value) {
-			if(m_pointer + 4 > m_buffer->Size()) {
+			if(m_pointer + 4 > m_size) {
 				return false;
 			}
 
-			value = *reinterpret_cast<int32_t *>(&m_buffer->Data()[m_pointer]);
+			memcpy(&value, &m_data[m_pointer], sizeof(value));
 			if(m_endianness == Endianness::Little) {
 				value = swap(value);
 			}
@@ -2322,12 +5904,25 @@ namespace ajson {
 			return true;
 		}
 
+		bool readLong(int64_t& value) {
+			if(m_pointer + 8 > m_size) {
+				return false;
+			}
+
+			memcpy(&value, &m_data[m_pointer], sizeof(value));
+			if(m_endianness == Endianness::Little) {
+				value = swap(value);
+			}
+			m_pointer += 8;
+			return true;
+		}
+
 		bool readFloat(float& value) {
-			if(m_pointer + 4 > m_buffer->Size()) {
+			if(m_pointer + 4 > m_size) {
 				return false;
 			}
 
-			value = *reinterpret_cast<float *>(&m_buffer->Data()[m_pointer]);
+			memcpy(&value, &m_data[m_pointer], sizeof(value));
 			if(m_endianness == Endianness::Little) {
 				value = swap(value);
 			}
@@ -2335,12 +5930,25 @@ namespace ajson {
 			return true;
 		}
 
+		bool readDouble(double& value) {
+			if(m_pointer + 8 > m_size) {
+				return false;
+			}
+
+			memcpy(&value, &m_data[m_pointer], sizeof(value));
+			if(m_endianness == Endianness::Little) {
+				value = swap(value);
+			}
+			m_pointer += 8;
+			return true;
+		}
+
 		bool readString(std::string& value) {
 			uint32_t start = m_pointer;
 			bool ended = false;
 
-			while(m_pointer != m_buffer->Size()) {
-				if(m_buffer->Data()[m_pointer] == '\0') {
+			while(m_pointer != m_size) {
+				if(m_data[m_pointer] == '\0') {
 					ended = true;
 					break;
 				}
@@ -2353,7 +5961,7 @@ namespace ajson {
 			}
 
 			m_pointer++;
-			value = std::move(std::string(&m_buffer->Data()[start]));
+			value.assign(&m_data[start], m_pointer - start - 1);
 			return true;
 		}
 
@@ -2366,14 +5974,15 @@ namespace ajson {
 		}
 
 		bool eof() {
-			if(m_pointer == m_buffer->Size()) {
+			if(m_pointer == m_size) {
 				return true;
 			} else {
 				return false;
 			}
 		}
 
-		BinaryBuffer* m_buffer;
+		const char* m_data;
+		uint32_t m_size;
 		uint32_t m_pointer;
 		Endianness m_endianness;
 	};
@@ -2437,6 +6046,16 @@ namespace ajson {
 			m_data.push_back(reinterpret_cast<char *>(&value)[3]);
 		}
 
+		void writeLong(int64_t value) {
+			if(m_endianness == Endianness::Little) {
+				value = swap(value);
+			}
+
+			for(int i = 0;i < 8;i++) {
+				m_data.push_back(reinterpret_cast<char *>(&value)[i]);
+			}
+		}
+
 		void writeFloat(float value) {
 			if(m_endianness == Endianness::Little) {
 				value = swap(value);
@@ -2448,6 +6067,16 @@ namespace ajson {
 			m_data.push_back(reinterpret_cast<char *>(&value)[3]);
 		}
 
+		void writeDouble(double value) {
+			if(m_endianness == Endianness::Little) {
+				value = swap(value);
+			}
+
+			for(int i = 0;i < 8;i++) {
+				m_data.push_back(reinterpret_cast<char *>(&value)[i]);
+			}
+		}
+
 		void writeString(const std::string& value) {
 			for(int i = 0;i < value.size();i++) {
 				m_data.push_back(value[i]);
@@ -2483,6 +6112,8 @@ namespace ajson {
 	const static int8_t BlobIdentifier = 11;
 	const static int8_t CommentIdentifier = 12;
 	const static int8_t ContainerEnd = 13;
+	const static int8_t Int64Identifier = 14;
+	const static int8_t DoubleIdentifier = 15;
 
 	void ParseBinaryNode(BinaryReader& reader, Node& node, CommentPolicy commentPolicy) {
 		if(node.GetType() == OBJECT_T) {
@@ -2555,6 +6186,14 @@ namespace ajson {
 						throw Exception(PARSER_ERROR, errorString);
 					}
 					node.CreateInt(value, nodeName);
+				} else if(type == Int64Identifier) {
+					int64_t value;
+					temp = reader.pointer();
+					if(!reader.readLong(value)) {
+						std::string errorString = ComposeBinaryError("Unexpected end of data, was excepting int64 value", temp);
+						throw Exception(PARSER_ERROR, errorString);
+					}
+					node.CreateInt64(value, nodeName);
 				} else if(type == FloatIdentifier) {
 					float value;
 					temp = reader.pointer();
@@ -2563,6 +6202,14 @@ namespace ajson {
 						throw Exception(PARSER_ERROR, errorString);
 					}
 					node.CreateFloat(value, nodeName);
+				} else if(type == DoubleIdentifier) {
+					double value;
+					temp = reader.pointer();
+					if(!reader.readDouble(value)) {
+						std::string errorString = ComposeBinaryError("Unexpected end of data, was expecting double value", temp);
+						throw Exception(PARSER_ERROR, errorString);
+					}
+					node.CreateDouble(value, nodeName);
 				} else if(type == BoolTrueIdentifier) {
 					node.CreateBool(true, nodeName);
 				} else if(type == BoolFalseIdentifier) {
@@ -2652,7 +6299,7 @@ namespace ajson {
 						std::string errorString = ComposeBinaryError("Unexpected end of data, was excepting int8 value", temp);
 						throw Exception(PARSER_ERROR, errorString);
 					}
-					node.CreateInt(value);
+					node.AppendInt64(value);
 				} else if(type == Int16Identifier) {
 					int16_t value;
 					temp = reader.pointer();
@@ -2660,7 +6307,7 @@ namespace ajson {
 						std::string errorString = ComposeBinaryError("Unexpected end of data, was excepting int16 value", temp);
 						throw Exception(PARSER_ERROR, errorString);
 					}
-					node.CreateInt(value);
+					node.AppendInt64(value);
 				} else if(type == Int32Identifier) {
 					int32_t value;
 					temp = reader.pointer();
@@ -2668,7 +6315,15 @@ namespace ajson {
 						std::string errorString = ComposeBinaryError("Unexpected end of data, was excepting int32 value", temp);
 						throw Exception(PARSER_ERROR, errorString);
 					}
-					node.CreateInt(value);
+					node.AppendInt64(value);
+				} else if(type == Int64Identifier) {
+					int64_t value;
+					temp = reader.pointer();
+					if(!reader.readLong(value)) {
+						std::string errorString = ComposeBinaryError("Unexpected end of data, was excepting int64 value", temp);
+						throw Exception(PARSER_ERROR, errorString);
+					}
+					node.AppendInt64(value);
 				} else if(type == FloatIdentifier) {
 					float value;
 					temp = reader.pointer();
@@ -2676,11 +6331,19 @@ namespace ajson {
 						std::string errorString = ComposeBinaryError("Unexpected end of data, was expecting float value", temp);
 						throw Exception(PARSER_ERROR, errorString);
 					}
-					node.CreateFloat(value);
+					node.AppendDouble(value);
+				} else if(type == DoubleIdentifier) {
+					double value;
+					temp = reader.pointer();
+					if(!reader.readDouble(value)) {
+						std::string errorString = ComposeBinaryError("Unexpected end of data, was expecting double value", temp);
+						throw Exception(PARSER_ERROR, errorString);
+					}
+					node.AppendDouble(value);
 				} else if(type == BoolTrueIdentifier) {
-					node.CreateBool(true);
+					node.AppendBool(true);
 				} else if(type == BoolFalseIdentifier) {
-					node.CreateBool(false);
+					node.AppendBool(false);
 				} else if(type == NullIdentifier) {
 					node.CreateNull();
 				} else if(type == BlobIdentifier) {
@@ -2726,7 +6389,15 @@ namespace ajson {
 	}
 
 	Node* ParseBinary(BinaryBuffer& buffer, CommentPolicy commentPolicy) {
-		BinaryReader reader(&buffer);
+		return ParseBinary(buffer.Data(), buffer.Size(), commentPolicy);
+	}
+
+	Node* ParseBinary(const char* data, size_t length, CommentPolicy commentPolicy) {
+		if(length > UINT32_MAX) {
+			throw Exception(PARSER_ERROR, "Input larger than 4 GiB is not supported.\n");
+		}
+
+		BinaryReader reader(data, static_cast<uint32_t>(length));
 		Node* rootNode = nullptr;
 
 		char firstChar;
@@ -2757,37 +6428,48 @@ namespace ajson {
 		return rootNode;
 	}
 
-	Node* ParseBinaryFile(const std::string& filename, CommentPolicy commentPolicy) {
-		FILE* fp = fopen(filename.c_str(), "r");
-		if(fp == nullptr)
-		{
-			std::string errorString = "Could not read from file '" + filename + "'.\n";
-			throw Exception(IO_ERROR, errorString);
-		}
-
-		fseek(fp, 0, SEEK_END);
-		size_t length = ftell(fp);
-		fseek(fp, 0, SEEK_SET);
-
-		char* parseBuffer = new char[length];
-		fread(parseBuffer, 1, length, fp);
-
-		fclose(fp);
+	Node* ParseBinaryFile(const std::string& filename, CommentPolicy commentPolicy, FileLoad fileLoad) {
+		FileView file(filename, fileLoad);
 
-		BinaryBuffer* buffer = new BinaryBuffer();
-		buffer->m_size = length;
-		buffer->m_data = parseBuffer;
+		return ParseBinary(file.Data(), file.Size(), commentPolicy);
+	}
 
-		Node* rootNode = ParseBinary(*buffer, commentPolicy);
+	static void WriteBinaryInt(BinaryWriter& writer, int64_t value) {
+		const static int8_t Int8Max = 0x7f;
+		const static int8_t Int8Min = 0x80;
+		const static int16_t Int16Max = 0x7fff;
+		const static int16_t Int16Min = 0x8000;
+
+		if(value > INT32_MAX || value < INT32_MIN) {
+			writer.writeChar(Int64Identifier);
+			writer.writeLong(value);
+		} else if(value > Int16Max || value < Int16Min) {
+			writer.writeChar(Int32Identifier);
+			writer.writeInt(value);
+		} else if(value > Int8Max || value < Int8Min) {
+			writer.writeChar(Int16Identifier);
+			writer.writeShort(value);
+		} else {
+			writer.writeChar(Int8Identifier);
+			writer.writeChar(value);
+		}
+	}
 
-		delete buffer;
-		return rootNode;
+	static void WriteBinaryFloat(BinaryWriter& writer, double value) {
+		// Only use the short form when no precision is lost
+		if(static_cast<double>(static_cast<float>(value)) == value) {
+			writer.writeChar(FloatIdentifier);
+			writer.writeFloat(static_cast<float>(value));
+		} else {
+			writer.writeChar(DoubleIdentifier);
+			writer.writeDouble(value);
+		}
 	}
 
 	void GenerateBinaryNode(BinaryWriter& writer, const Node& node, CommentPolicy commentPolicy) {
 		if(node.GetType() == OBJECT_T) {
 			writer.writeChar(ObjectIdentifier);
-			for(int i = 0;i < node.Children();i++) {
+			for(uint32_t i = 0;i < node.Children();i++) {
 				if(node.GetChild(i)->GetType() != COMMENT_T) {
 					writer.writeString(node.GetChild(i)->GetName());
 					GenerateBinaryNode(writer, *node.GetChild(i), commentPolicy);
@@ -2799,9 +6481,21 @@ namespace ajson {
 				}
 			}
 			writer.writeChar(ContainerEnd);
+		} else if(node.GetType() == ARRAY_T && node.IsPacked()) {
+			writer.writeChar(ArrayIdentifier);
+			for(uint32_t i = 0;i < node.Children();i++) {
+				if(node.GetPackedType() == INT_T) {
+					WriteBinaryInt(writer, node.GetPackedInts()[i]);
+				} else if(node.GetPackedType() == FLOAT_T) {
+					WriteBinaryFloat(writer, node.GetPackedDoubles()[i]);
+				} else {
+					writer.writeChar(node.GetPackedBools()[i] ? BoolTrueIdentifier : BoolFalseIdentifier);
+				}
+			}
+			writer.writeChar(ContainerEnd);
 		} else if(node.GetType() == ARRAY_T) {
 			writer.writeChar(ArrayIdentifier);
-			for(int i = 0;i < node.Children();i++) {
+			for(uint32_t i = 0;i < node.Children();i++) {
 				if(node.GetChild(i)->GetType() != COMMENT_T) {
 					GenerateBinaryNode(writer, *node.GetChild(i), commentPolicy);
 				} else {
@@ -2815,31 +6509,11 @@ namespace ajson {
 			writer.writeChar(StringIdentifier);
 			writer.writeString(node.GetString());
 		} else if(node.GetType() == INT_T) {
-			const static int8_t Int8Max = 0x7f;
-			const static int8_t Int8Min = 0x80;
-			const static int16_t Int16Max = 0x7fff;
-			const static int16_t Int16Min = 0x8000;
-
-			int32_t value = node.GetInt();
-			if(value > Int16Max || value < Int16Min) {
-				writer.writeChar(Int32Identifier);
-				writer.writeInt(value);
-			} else if(value > Int8Max || value < Int8Min) {
-				writer.writeChar(Int16Identifier);
-				writer.writeShort(value);
-			} else {
-				writer.writeChar(Int8Identifier);
-				writer.writeChar(value);
-			}
+			WriteBinaryInt(writer, node.GetInt64());
 		} else if(node.GetType() == FLOAT_T) {
-			writer.writeChar(FloatIdentifier);
-			writer.writeFloat(node.GetFloat());
+			WriteBinaryFloat(writer, node.GetDouble());
 		} else if(node.GetType() == BOOL_T) {
-			if(node.GetBool() == true) {
-				writer.writeChar(BoolTrueIdentifier);
-			} else {
-				writer.writeChar(BoolFalseIdentifier);
-			}
+			writer.writeChar(node.GetBool() ? BoolTrueIdentifier : BoolFalseIdentifier);
 		} else if(node.GetType() == NULL_T) {
 			writer.writeChar(NullIdentifier);
 		} else if(node.GetType() == BLOB_T) {
@@ -5,11 +5,23 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <string>
 #include <sstream>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#define AJSON_STRING_VIEW
+#endif
+
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <span>
+#define AJSON_SPAN
+#endif
+
 /**
  * @mainpage libajson
  * @section intro_section Introduction
@@ -96,6 +108,65 @@ namespace ajson
 		IO_ERROR
 	};
 
+	/**
+	 * @brief Parsing strategy of ParseJson() and ParseJsonFile().
+	 */
+	enum ParseMode : char
+	{
+		/**
+		 * @brief Tokenize the whole buffer first, then build nodes from the token list.
+		 */
+		PARSE_TOKENIZED,
+		/**
+		 * @brief Build nodes while tokenizing, the token list is never stored. Lower peak memory.
+		 */
+		PARSE_SINGLE_PASS,
+		/**
+		 * @brief Like PARSE_SINGLE_PASS, but a large root array is split at its elements and parsed on all hardware threads.
+		 * Other inputs, and parsing into a Document, use PARSE_SINGLE_PASS. Comments stop the split, the rest of the
+		 * array is parsed by one thread.
+		 */
+		PARSE_PARALLEL
+	};
+
+	/**
+	 * @brief Whether parsing checks that strings and comments are well-formed UTF-8.
+	 */
+	enum Utf8Policy : char
+	{
+		/**
+		 * @brief Bytes of strings and comments are taken as they are.
+		 */
+		UTF8_UNCHECKED,
+		/**
+		 * @brief Throw PARSER_ERROR on malformed or truncated sequences, overlong encodings, surrogates and code points
+		 * above U+10FFFF. Checked while scanning strings, ASCII input costs close to nothing extra.
+		 */
+		UTF8_VALIDATE
+	};
+
+	/**
+	 * @brief How ParseJsonFile() and ParseBinaryFile() bring the file into memory.
+	 * Mapping avoids copying the file, it doesn't lift the 4 GiB input limit of the parsers, which use 32-bit offsets.
+	 * Only ParseJsonLinesFile() accepts larger files, as long as every record stays below 4 GiB.
+	 */
+	enum FileLoad : char
+	{
+		/**
+		 * @brief Read the whole file into a heap buffer first.
+		 */
+		LOAD_READ,
+		/**
+		 * @brief Map the file read-only and parse straight from the page cache, pages are faulted in as the parser reaches them.
+		 * Falls back to LOAD_READ where mapping is not available.
+		 */
+		LOAD_MAPPED,
+		/**
+		 * @brief Like LOAD_MAPPED, but fault the whole file in up front (MAP_POPULATE) where supported.
+		 */
+		LOAD_MAPPED_POPULATE
+	};
+
 	enum CommentPolicy : char
 	{
 		/**
@@ -112,14 +183,257 @@ namespace ajson
 		ACCEPT_COMMENTS
 	};
 
+	/**
+	 * @brief Where DestroyNode() frees the subtree.
+	 */
+	enum DestroyMode : char
+	{
+		/**
+		 * @brief Free the subtree before returning.
+		 */
+		DESTROY_NOW,
+		/**
+		 * @brief Unlink the node, then free the subtree on a detached thread.
+		 */
+		DESTROY_IN_BACKGROUND
+	};
+
+	/**
+	 * @brief Bump allocator owned by a Document.
+	 * Allocations are never freed individually, all memory is released at once by Reset() or destruction.
+	 */
+	class Arena final
+	{
+	public:
+		explicit Arena(size_t blockSize);
+		~Arena();
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		inline void* Allocate(size_t size) {
+			size = (size + Alignment - 1) & ~(Alignment - 1);
+			if(size > static_cast<size_t>(m_end - m_current)) {
+				return AllocateBlock(size);
+			}
+
+			void* memory = m_current;
+			m_current += size;
+			return memory;
+		}
+
+		/**
+		 * @brief Releases all allocations. The largest block of at most MaxBlockSize is kept for reuse.
+		 */
+		void Reset();
+	private:
+		const static size_t Alignment = 16;
+		const static size_t MaxBlockSize = 16 * 1024 * 1024;
+
+		struct Block
+		{
+			Block*	next;
+			size_t	size;
+		};
+
+		void* AllocateBlock(size_t size);
+
+		Block*	m_blocks;
+		char*	m_current;
+		char*	m_end;
+		size_t	m_blockSize;
+	};
+
+	/**
+	 * @brief String type used for node names and string values.
+	 * Up to InlineCapacity bytes are stored inside the string itself, longer text is copied to a buffer
+	 * from the heap or from a document arena. The owning node frees it with Clear().
+	 */
+	class NodeString final
+	{
+	public:
+		const static uint32_t InlineCapacity = 15;
+
+		NodeString() {
+			m_bytes[InlineCapacity] = 0;
+		}
+
+		inline bool IsInline() const {
+			return static_cast<uint8_t>(m_bytes[InlineCapacity]) <= InlineCapacity;
+		}
+
+		inline const char* Data() const {
+			if(IsInline()) {
+				return m_bytes;
+			}
+			const char* data;
+			memcpy(&data, m_bytes, sizeof(data));
+			return data;
+		}
+
+		inline uint32_t Size() const {
+			if(IsInline()) {
+				return static_cast<uint8_t>(m_bytes[InlineCapacity]);
+			}
+			uint32_t size;
+			memcpy(&size, m_bytes + sizeof(char*), sizeof(size));
+			return size;
+		}
+
+		/**
+		 * @brief Compares text, interned names of a document match by address without reading the text.
+		 */
+		inline bool Equals(const char* data, size_t size) const {
+			if(Size() != size) {
+				return false;
+			}
+			const char* text = Data();
+			return text == data || memcmp(text, data, size) == 0;
+		}
+
+		/**
+		 * @brief Replaces the text. Text that doesn't fit inline is copied to 'arena', or to the heap without one.
+		 */
+		void Assign(const char* data, size_t size, Arena* arena);
+		/**
+		 * @brief Replaces the text with a reference to text of at least InlineCapacity bytes that lives in an arena.
+		 * Nothing is copied, used for names interned by a Document.
+		 */
+		void AssignShared(const char* data, size_t size);
+		/**
+		 * @brief Frees a heap buffer and leaves the string empty.
+		 */
+		void Clear();
+		/**
+		 * @brief Takes over the text and buffer of 'other', leaving it empty.
+		 */
+		inline void Take(NodeString& other) {
+			memcpy(m_bytes, other.m_bytes, sizeof(m_bytes));
+			other.m_bytes[InlineCapacity] = 0;
+		}
+	private:
+		/**
+		 * Values of the last byte for out of line text, inline text stores its length there.
+		 */
+		const static uint8_t HeapTag = 0xFE;
+		const static uint8_t ArenaTag = 0xFF;
+
+		char	m_bytes[InlineCapacity + 1];
+	};
+
+	class Node;
+
+	/**
+	 * @brief Child pointers of an object or array node.
+	 * Like NodeString the buffer comes from the heap or a document arena and is managed by the owning node,
+	 * a growing arena list leaves its old buffer to the arena.
+	 */
+	class NodeList final
+	{
+	public:
+		NodeList() : m_items{nullptr}, m_size{0}, m_capacity{0} {}
+
+		inline uint32_t Size() const {
+			return m_size;
+		}
+
+		inline bool Empty() const {
+			return m_size == 0;
+		}
+
+		inline Node* operator[](uint32_t n) const {
+			return m_items[n];
+		}
+
+		inline Node* const* Begin() const {
+			return m_items;
+		}
+
+		inline Node* const* End() const {
+			return m_items + m_size;
+		}
+
+		inline void Append(Node* node, Arena* arena) {
+			if(m_size == m_capacity) {
+				Reserve(m_size + 1, arena);
+			}
+			m_items[m_size++] = node;
+		}
+
+		void Insert(uint32_t n, Node* node, Arena* arena);
+		void Erase(uint32_t n);
+		/**
+		 * @brief Grows the buffer to hold at least 'capacity' children, at least doubling it.
+		 */
+		void Reserve(uint32_t capacity, Arena* arena);
+
+		/**
+		 * @brief Drops all children but keeps the buffer.
+		 */
+		inline void Clear() {
+			m_size = 0;
+		}
+
+		/**
+		 * @brief Frees a heap buffer, pass the arena the buffer came from or nullptr.
+		 */
+		void Free(Arena* arena);
+	private:
+		Node**		m_items;
+		uint32_t	m_size;
+		uint32_t	m_capacity;
+	};
+
+	/**
+	 * @brief Elements of an array of only ints, only floats or only booleans, stored without a Node each.
+	 * Like NodeList the buffer comes from the heap or a document arena and is managed by the owning node.
+	 */
+	class PackedArray final
+	{
+	public:
+		PackedArray() : m_items{nullptr}, m_size{0}, m_capacity{0} {}
+
+		inline uint32_t Size() const {
+			return m_size;
+		}
+
+		template<typename T> inline const T* Data() const {
+			return static_cast<const T*>(m_items);
+		}
+
+		template<typename T> inline void Append(T value, Arena* arena) {
+			if(m_size == m_capacity) {
+				Reserve(m_size + 1, sizeof(T), arena);
+			}
+			static_cast<T*>(m_items)[m_size++] = value;
+		}
+
+		/**
+		 * @brief Grows the buffer to hold at least 'capacity' elements, at least doubling it.
+		 */
+		void Reserve(uint32_t capacity, size_t elementSize, Arena* arena);
+		/**
+		 * @brief Frees a heap buffer, pass the arena the buffer came from or nullptr.
+		 */
+		void Free(Arena* arena);
+	private:
+		void*		m_items;
+		uint32_t	m_size;
+		uint32_t	m_capacity;
+	};
+
 	union Value
 	{
+		Value() : intValue(0) {}
+
 		bool					boolValue;
 		char					charValue;
-		std::string*			stringValue;
+		NodeString				stringValue;
+		NodeList				children;
+		PackedArray				packedValue;
 		std::vector<uint8_t>*	blobValue;
-		int32_t					intValue;
-		float					floatValue;
+		int64_t					intValue;
+		double					floatValue;
 	};
 
 	/**
@@ -139,8 +453,8 @@ namespace ajson
 		COMMENT_T
 	};
 
-	class Node;
 	class NodeIterator;
+	class Document;
 
 	class Exception
 	{
@@ -181,6 +495,16 @@ namespace ajson
 		 */
 		explicit Node(float floatValue, const std::string& name = "");
 
+		/**
+		 * 64-bit int type ctor
+		 */
+		explicit Node(int64_t intValue, const std::string& name = "");
+
+		/**
+		 * Double type ctor
+		 */
+		explicit Node(double floatValue, const std::string& name = "");
+
 		/**
 		 * Bool type ctor
 		 */
@@ -295,8 +619,17 @@ namespace ajson
 		 * @brief Gets name of the node.
 		 */
 		std::string	GetName() const {
-			return m_name;
+			return std::string(m_name.Data(), m_name.Size());
+		}
+#if defined(AJSON_STRING_VIEW)
+		/**
+		 * @brief Gets name of the node without copying it.
+		 * The view is invalidated by SetName() and by destroying the node.
+		 */
+		inline std::string_view GetNameView() const {
+			return std::string_view(m_name.Data(), m_name.Size());
 		}
+#endif
 		/**
 		 * @brief Sets node name.
 		 */
@@ -317,6 +650,18 @@ namespace ajson
 		 * @brief Get the string value.
 		 */
 		std::string	GetString() const;
+#if defined(AJSON_STRING_VIEW)
+		/**
+		 * @brief Get the string value without copying it.
+		 * Empty if node type is not STRING_T. The view is invalidated by changing the value or type.
+		 */
+		inline std::string_view GetStringView() const {
+			if(m_type != STRING_T) {
+				return std::string_view();
+			}
+			return std::string_view(m_value.stringValue.Data(), m_value.stringValue.Size());
+		}
+#endif
 		/**
 		 * @brief Set the node type to string and set string value.
 		 * Deletes all children if node is a container type.
@@ -327,6 +672,18 @@ namespace ajson
 		 * @brief Get comment text
 		 */
 		std::string GetComment() const;
+#if defined(AJSON_STRING_VIEW)
+		/**
+		 * @brief Get comment text without copying it.
+		 * Empty if node type is not COMMENT_T.
+		 */
+		inline std::string_view GetCommentView() const {
+			if(m_type != COMMENT_T) {
+				return std::string_view();
+			}
+			return std::string_view(m_name.Data(), m_name.Size());
+		}
+#endif
 
 		/**
 		 * @brief Set the node type to comment and set it's text.
@@ -335,7 +692,7 @@ namespace ajson
 		void 		SetComment(const std::string& val);
 
 		/**
-		 * @brief Get the int value.
+		 * @brief Get the int value, truncated to 32 bits.
 		 */
 		int32_t		GetInt() const;
 		/**
@@ -345,7 +702,17 @@ namespace ajson
 		void		SetInt(int32_t val);
 
 		/**
-		 * @brief Get the float value.
+		 * @brief Get the full 64-bit int value.
+		 */
+		int64_t		GetInt64() const;
+		/**
+		 * @brief Set the node type to int and set 64-bit int value.
+		 * Deletes all children recursively if node is a container type.
+		 */
+		void		SetInt64(int64_t val);
+
+		/**
+		 * @brief Get the float value, rounded to single precision.
 		 */
 		float		GetFloat() const;
 		/**
@@ -354,6 +721,16 @@ namespace ajson
 		 */
 		void		SetFloat(float val);
 
+		/**
+		 * @brief Get the full double precision value.
+		 */
+		double		GetDouble() const;
+		/**
+		 * @brief Set the node type to float and set double value.
+		 * Deletes all children recursively if node is a container type.
+		 */
+		void		SetDouble(double val);
+
 		/**
 		 * @brief Get blob value.
 		 * Returns empty vector if node is not blob type.
@@ -381,18 +758,107 @@ namespace ajson
 		/**
 		 * @brief Number of children.
 		 */
-		uint16_t 	Children() const;
+		uint32_t 	Children() const;
 		/**
 		 * @brief Get the nth child of node.
 		 * Returns nullptr if out of bounds.
 		 * Returns nullptr if node is not container type.
+		 * Child pointers stay valid while siblings are added or removed.
+		 * Returns nullptr for the elements of packed arrays, see GetPackedType().
 		 */
-		Node*		GetChild(uint16_t n) const;
+		Node*		GetChild(uint32_t n) const;
 		/**
 		 * @brief Search child nodes in object node by name and returns last occurrence of name or nullptr if not found.
 		 * Returns nullptr if node is not object type.
+		 * Objects with at least KeyIndexThreshold children are searched through a hash index.
+		 */
+		inline Node* GetChild(const std::string& name) const {
+			return GetChild(name.data(), name.size());
+		}
+		/**
+		 * @brief Search child nodes by a name that is not NUL terminated, see GetChild(const std::string&).
+		 */
+		Node*		GetChild(const char* name, size_t length) const;
+		/**
+		 * @brief Search child nodes by a NUL terminated name, see GetChild(const std::string&).
+		 * A template so that GetChild(0) still picks the index overload.
+		 */
+		template<typename T, typename = typename std::enable_if<std::is_convertible<T, const char*>::value && !std::is_integral<T>::value>::type>
+		inline Node* GetChild(T name) const {
+			const char* data = name;
+			return GetChild(data, strlen(data));
+		}
+#if defined(AJSON_STRING_VIEW)
+		inline Node* GetChild(std::string_view name) const {
+			return GetChild(name.data(), name.size());
+		}
+#endif
+
+		/**
+		 * @brief Element type of a packed array, NULL_T for any other node.
+		 * A Document with Document::SetPackArrays() stores arrays whose elements are all INT_T, all FLOAT_T
+		 * or all BOOL_T in one typed buffer instead of a node per element, Children() counts the elements.
+		 * The elements have no nodes, GetChild() returns nullptr and iteration visits nothing until Unpack()
+		 * converts the array. Any change other than the Append functions unpacks too.
+		 */
+		inline enum NodeType GetPackedType() const {
+			return m_packedType;
+		}
+
+		inline bool IsPacked() const {
+			return m_packedType != NULL_T;
+		}
+
+		/**
+		 * @brief Elements of a packed INT_T array, nullptr for any other node.
+		 */
+		const int64_t*	GetPackedInts() const;
+		/**
+		 * @brief Elements of a packed FLOAT_T array, nullptr for any other node.
+		 */
+		const double*	GetPackedDoubles() const;
+		/**
+		 * @brief Elements of a packed BOOL_T array, nullptr for any other node.
+		 */
+		const bool*		GetPackedBools() const;
+#if defined(AJSON_SPAN)
+		inline std::span<const int64_t> GetIntSpan() const {
+			return std::span<const int64_t>(GetPackedInts(), m_packedType == INT_T ? Children() : 0);
+		}
+
+		inline std::span<const double> GetDoubleSpan() const {
+			return std::span<const double>(GetPackedDoubles(), m_packedType == FLOAT_T ? Children() : 0);
+		}
+
+		inline std::span<const bool> GetBoolSpan() const {
+			return std::span<const bool>(GetPackedBools(), m_packedType == BOOL_T ? Children() : 0);
+		}
+#endif
+
+		/**
+		 * @brief Appends an element to an array without returning a node for it.
+		 * In a document that packs arrays the element is packed if the array is empty or already packed
+		 * with the same type, otherwise a child node is added. Throws if node is not an array.
+		 */
+		void		AppendInt64(int64_t value);
+		void		AppendDouble(double value);
+		void		AppendBool(bool value);
+
+		/**
+		 * @brief Converts a packed array to child nodes, does nothing for any other node.
+		 * Pointers returned by the GetPacked functions become invalid.
+		 */
+		void		Unpack();
+
+		/**
+		 * @brief Builds the name lookup index of objects with at least KeyIndexThreshold children.
+		 * Objects build it themselves once they reach the threshold and keep it up to date on every
+		 * change, lookups never modify a node. Renaming or removing a child of an indexed object
+		 * rebuilds its index.
 		 */
-		Node*		GetChild(const std::string& name) const;
+		void		BuildKeyIndex(bool recursive = false);
+
+		const static uint32_t KeyIndexThreshold = 32;
 
 		Node*		GetFirstChild() const;
 		Node*		GetLastChild() const;
@@ -408,13 +874,14 @@ namespace ajson
 		Node*		AddChild(Node* node);
 		/**
 		 * @brief Add child at specific location. Node is left moved from state. Use returned pointer instead.
+		 * Appends if index is past the last child.
 		 */
-		Node*		AddChild(Node* node, uint16_t index);
+		Node*		AddChild(Node* node, uint32_t index);
 		/**
 		 * @brief Removes the nth child.
 		 * No effect if the nth child doesn't exist.
 		 */
-		void		RemoveChild(uint16_t n);
+		void		RemoveChild(uint32_t n);
 		void		RemoveChild(Node* node);
 
 		void		RemoveAllChildren();
@@ -426,6 +893,8 @@ namespace ajson
 		Node* 		CreateString(const std::string& value, const std::string& name = "");
 		Node* 		CreateInt(int32_t value, const std::string& name = "");
 		Node*		CreateFloat(float value, const std::string& name = "");
+		Node* 		CreateInt64(int64_t value, const std::string& name = "");
+		Node*		CreateDouble(double value, const std::string& name = "");
 		Node* 		CreateBool(bool value, const std::string& name = "");
 		Node* 		CreateNull(const std::string& name = "");
 
@@ -445,17 +914,219 @@ namespace ajson
 		 * @brief Returns the nesting level of a node.
 		 * E.g. The root node has a depth of 0 and its children a depth of 1, children of its children a depth of 2 and so on.
 		 */
-		uint16_t	GetDepth() const;
+		uint32_t	GetDepth() const;
+
+		/**
+		 * @brief Document owning this node, nullptr for heap allocated nodes.
+		 */
+		inline Document* GetDocument() const {
+			return m_document;
+		}
 	private:
-		Node*				m_parent;
-		std::vector<Node>	m_children;
+		friend class Document;
+		friend class ArrayParser;
+		friend void DestroyNode(Node* node, DestroyMode destroyMode);
 
-		std::string			m_name;
+		struct KeyIndex;
 
+		inline bool IsContainer() const {
+			return m_type == OBJECT_T || m_type == ARRAY_T;
+		}
+
+		/**
+		 * Node allocated from a document arena.
+		 */
+		Node(Document* document, enum NodeType type);
+
+		/**
+		 * Allocates a detached node in the same document as this, or on the heap.
+		 */
+		Node*		NewNode(enum NodeType type, const std::string& name) const;
+		/**
+		 * Frees a detached node allocated by NewNode().
+		 */
+		static void	FreeNode(Node* node);
+		/**
+		 * Sets the name, document nodes share one interned copy of every long name.
+		 */
+		void		AssignName(const char* name, size_t length);
+		/**
+		 * Appends to an empty or packed array of the same element type if the document packs arrays, returns false for anything else.
+		 */
+		template<typename T> bool Pack(enum NodeType type, T value);
+		/**
+		 * Allocates storage for the current string or blob type.
+		 */
+		void		AllocateValue();
+		/**
+		 * Frees string or blob storage and resets type to NULL_T.
+		 */
+		void		FreeValue();
+
+		/**
+		 * Appends a node allocated by NewNode().
+		 */
+		Node*		LinkChild(Node* child);
+		/**
+		 * Unlinks a child without deleting it.
+		 */
+		void		ReleaseChild(Node* node);
+		/**
+		 * Moves all children of a heap allocated node to the end of this node's children without copying them.
+		 */
+		void		SpliceChildren(Node* node);
+
+		/**
+		 * Adds the last child to the name index, if there is one.
+		 */
+		void		IndexChild(Node* child);
+		/**
+		 * Discards the name index, called on any mutation other than append.
+		 */
+		void		DropKeyIndex();
+		/**
+		 * Rebuilds the name indexes of the parents of this node and 'source' after a move between them.
+		 */
+		void		ReindexParents(Node& source);
+		/**
+		 * Arena of the owning document or nullptr for heap allocated nodes.
+		 */
+		Arena*		GetArena() const;
+
+		// Ordered so the types fit in the padding after the name, 64 bytes on 64-bit targets
+		Node*				m_parent;
+		Document*			m_document;
+		KeyIndex*			m_keyIndex;
+
+		NodeString			m_name;
 		enum NodeType		m_type;
+		enum NodeType		m_packedType;
+
+		// Children or packed elements of containers, value of everything else
 		union Value			m_value;
 	};
 
+	/**
+	 * @brief Owns a tree of nodes, their names and string values in an arena.
+	 * Parsing into a document replaces malloc per node with bump allocation, and the whole
+	 * tree is freed at once by Reset() or destruction. Nodes of a document must not be deleted
+	 * directly, use Node::RemoveChild() or DestroyNode(). Not safe for concurrent use,
+	 * use one document per thread.
+	 *
+	 * @code{.cpp}
+	 * Document document;
+	 * for(const std::string& message : messages) {
+	 * 	Node* root = document.Parse(message);
+	 * 	...
+	 * }
+	 * @endcode
+	 */
+	class Document final
+	{
+	public:
+		const static size_t DefaultBlockSize = 64 * 1024;
+
+		explicit Document(size_t blockSize = DefaultBlockSize);
+		~Document();
+
+		Document(const Document&) = delete;
+		Document& operator=(const Document&) = delete;
+
+		/**
+		 * @brief Root node or nullptr if the document is empty.
+		 */
+		inline Node* GetRoot() const {
+			return m_root;
+		}
+
+		/**
+		 * @brief Replaces the root with a new empty node.
+		 * Memory of the previous tree is only reclaimed by Reset().
+		 */
+		Node*		CreateRoot(enum NodeType type = OBJECT_T);
+
+		/**
+		 * @brief Resets the document and parses json from buffer into it.
+		 * The document is left empty if parsing throws.
+		 */
+		Node*		Parse(const std::string& parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+		/**
+		 * @brief Resets the document and parses 'length' bytes of json into it.
+		 * The input is only read, it doesn't have to be NUL terminated.
+		 */
+		Node*		Parse(const char* data, size_t length, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+		/**
+		 * @brief Resets the document and parses NUL terminated json into it.
+		 */
+		inline Node* Parse(const char* data, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+			return Parse(data, strlen(data), commentPolicy, parseMode, utf8Policy);
+		}
+#if defined(AJSON_STRING_VIEW)
+		inline Node* Parse(std::string_view parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+			return Parse(parseBuffer.data(), parseBuffer.size(), commentPolicy, parseMode, utf8Policy);
+		}
+#endif
+		/**
+		 * @brief Resets the document and parses only the given paths into it, see the projecting ParseJson().
+		 */
+		Node*		Parse(const char* data, size_t length, const std::vector<std::string>& paths, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+		Node*		Parse(const std::string& parseBuffer, const std::vector<std::string>& paths, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+		/**
+		 * @brief Resets the document and parses json file into it.
+		 * Throws exception if it can't open specified file for reading, or PARSER_ERROR if it is 4 GiB or larger.
+		 */
+		Node*		ParseFile(const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, FileLoad fileLoad = LOAD_MAPPED, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+		/**
+		 * @brief Store arrays of only ints, floats or booleans in one typed buffer, off by default.
+		 * Applies to arrays filled after the call, see Node::GetPackedType().
+		 */
+		inline void SetPackArrays(bool packArrays) {
+			m_packArrays = packArrays;
+		}
+
+		inline bool GetPackArrays() const {
+			return m_packArrays;
+		}
+
+		/**
+		 * @brief Frees all nodes at once, independent of their number. Previously returned nodes become invalid.
+		 */
+		void		Reset();
+	private:
+		friend class Node;
+
+		/**
+		 * Names longer than NodeString::InlineCapacity are stored once per document and
+		 * shared by all nodes with that name, so object lookups compare addresses.
+		 */
+		struct KeySlot
+		{
+			const char*	data;
+			uint32_t	size;
+			uint32_t	hash;
+		};
+
+		std::vector<uint8_t>* CreateBlob();
+
+		/**
+		 * Returns the document's copy of a name, copying it into the arena the first time.
+		 */
+		const char*	InternKey(const char* data, uint32_t size);
+		/**
+		 * Returns the document's copy of a name with the given HashKey() or nullptr if no node of the document has it.
+		 */
+		const char*	FindKey(const char* data, uint32_t size, uint32_t hash) const;
+		uint32_t	FindKeySlot(const char* data, uint32_t size, uint32_t hash) const;
+
+		Arena								m_arena;
+		std::vector<std::vector<uint8_t>*>	m_blobs;
+		std::vector<KeySlot>				m_keys;
+		uint32_t							m_keyCount;
+		Node*								m_root;
+		bool								m_packArrays;
+	};
+
 	/**
 	 * @brief Convenience class for iterating over nodes.
 	 */
@@ -583,7 +1254,11 @@ namespace ajson
 	void 			GenerateBinaryFile(const Node& node, const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS);
 
 	Node*			ParseBinary(BinaryBuffer& buffer, CommentPolicy commentPolicy = IGNORE_COMMENTS);
-	Node* 			ParseBinaryFile(const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+	/**
+	 * @brief Parse 'length' bytes of binary data, the input is only read.
+	 */
+	Node*			ParseBinary(const char* data, size_t length, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+	Node* 			ParseBinaryFile(const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS, FileLoad fileLoad = LOAD_MAPPED);
 
 	template<enum JsonOutput formatStyle = JSON_SPACED>
 		   		void GenerateJsonFile(const Node& node, const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS);
@@ -602,6 +1277,10 @@ namespace ajson
 	 */
 	template<> 	void GenerateJsonFile<JSON_COMPACT>(const Node& node, const std::string& filename, CommentPolicy commentPolicy);
 
+	/**
+	 * @brief Generate json text from a node and its children.
+	 * Infinite and NaN floats have no json representation and are written as null.
+	 */
 	template<enum JsonOutput formatStyle = JSON_SPACED>
 				std::string GenerateJson(const Node& node, CommentPolicy commentPolicy = IGNORE_COMMENTS);
 
@@ -614,18 +1293,362 @@ namespace ajson
 	 */
 	template<>	std::string GenerateJson<JSON_SPACED>(const Node& node, CommentPolicy commentPolicy);
 
+	/**
+	 * @brief Delete a heap allocated node and its whole subtree in linear time.
+	 * The node is removed from its parent first. With DESTROY_IN_BACKGROUND the memory is
+	 * released on a detached thread, the node must not be used after the call.
+	 */
+	void		DestroyNode(Node* node, DestroyMode destroyMode = DESTROY_NOW);
+
 	/**
 	 * @brief Parse json from buffer.
+	 * Integers beyond the int64 range are stored as FLOAT_T, numbers beyond the range of double
+	 * throw a PARSER_ERROR instead of becoming an infinity.
 	 *
 	 * @sa parseJsonFile
 	 **/
-	Node*		ParseJson(const std::string& parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+	Node*		ParseJson(const std::string& parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+	/**
+	 * @brief Parse 'length' bytes of json.
+	 * The input is only read and never copied, it doesn't have to be NUL terminated.
+	 * E.g. it can point directly into a network receive buffer.
+	 */
+	Node*		ParseJson(const char* data, size_t length, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+	/**
+	 * @brief Parse NUL terminated json.
+	 */
+	inline Node* ParseJson(const char* data, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+		return ParseJson(data, strlen(data), commentPolicy, parseMode, utf8Policy);
+	}
+
+#if defined(AJSON_STRING_VIEW)
+	inline Node* ParseJson(std::string_view parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+		return ParseJson(parseBuffer.data(), parseBuffer.size(), commentPolicy, parseMode, utf8Policy);
+	}
+#endif
+
+	/**
+	 * @brief Parse json, but only build nodes for the values at 'paths' and their ancestors.
+	 * Paths are JSON Pointers ("/user/id", "/items/0") or dot separated ("user.id", "items.0"), a "*" segment
+	 * matches every member or element and an empty path the whole document. Matched values are built with
+	 * their complete subtree, ancestors only get the matched children. Everything else is validated but no
+	 * nodes are created for it.
+	 */
+	Node*		ParseJson(const char* data, size_t length, const std::vector<std::string>& paths, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+	Node*		ParseJson(const std::string& parseBuffer, const std::vector<std::string>& paths, CommentPolicy commentPolicy = IGNORE_COMMENTS);
 
 	/**
 	 * @brief Parse json from file.
+	 * Throws exception if it can't open specified file for reading, or PARSER_ERROR if it is 4 GiB or larger.
+	 * By default the file is memory mapped instead of copied, see FileLoad.
+	 */
+	Node*	 	ParseJsonFile(const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS, ParseMode parseMode = PARSE_SINGLE_PASS, FileLoad fileLoad = LOAD_MAPPED, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+	/**
+	 * @brief Receives parse events from the event-driven ParseJson() overloads, no nodes are created.
+	 * Override the events of interest, the rest are ignored. String data has its escape sequences decoded to
+	 * UTF-8, it points into the input buffer (without the quotes) unless the string contains escapes, and is
+	 * only valid during the call. Throw from any event to stop parsing.
+	 *
+	 * @code
+	 * struct CountNames : public JsonHandler {
+	 * 	void Key(const char* data, uint32_t size) override {
+	 * 		if(size == 4 && memcmp(data, "name", 4) == 0) count++;
+	 * 	}
+	 * 	int count = 0;
+	 * };
+	 * @endcode
+	 */
+	class JsonHandler
+	{
+	public:
+		virtual ~JsonHandler() {}
+
+		virtual void StartObject() {}
+		virtual void EndObject() {}
+		virtual void StartArray() {}
+		virtual void EndArray() {}
+		/**
+		 * @brief Member name, followed by the events of its value.
+		 */
+		virtual void Key(const char* /*data*/, uint32_t /*size*/) {}
+		virtual void String(const char* /*data*/, uint32_t /*size*/) {}
+		virtual void Int(int64_t /*value*/) {}
+		virtual void Float(double /*value*/) {}
+		virtual void Bool(bool /*value*/) {}
+		virtual void Null() {}
+		virtual void Blob(const std::vector<uint8_t>& /*value*/) {}
+		/**
+		 * @brief Comment text without the delimiters, only reported with ACCEPT_COMMENTS.
+		 */
+		virtual void Comment(const char* /*data*/, uint32_t /*size*/) {}
+	};
+
+	/**
+	 * @brief Parse 'length' bytes of json, reporting it to handler instead of building nodes.
+	 * Uses the same tokenizer and validation as PARSE_SINGLE_PASS.
+	 */
+	void		ParseJson(const char* data, size_t length, JsonHandler& handler, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+	void		ParseJson(const std::string& parseBuffer, JsonHandler& handler, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+	inline void ParseJson(const char* data, JsonHandler& handler, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+		ParseJson(data, strlen(data), handler, commentPolicy, utf8Policy);
+	}
+
+#if defined(AJSON_STRING_VIEW)
+	inline void ParseJson(std::string_view parseBuffer, JsonHandler& handler, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+		ParseJson(parseBuffer.data(), parseBuffer.size(), handler, commentPolicy, utf8Policy);
+	}
+#endif
+
+	/**
+	 * @brief Parse json file, reporting it to handler instead of building nodes.
+	 * Throws exception if it can't open specified file for reading, or PARSER_ERROR if it is 4 GiB or larger.
+	 */
+	void		ParseJsonFile(const std::string& filename, JsonHandler& handler, CommentPolicy commentPolicy = IGNORE_COMMENTS, FileLoad fileLoad = LOAD_MAPPED, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+	/**
+	 * @brief Checks that 'length' bytes are valid json, including blobs and comments, without building nodes.
+	 * Returns false and stores the message ParseJson() would throw in 'error' if given. Like ParseJson(),
+	 * empty input is accepted.
+	 */
+	bool		Validate(const char* data, size_t length, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED, std::string* error = nullptr);
+	bool		Validate(const std::string& parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED, std::string* error = nullptr);
+
+	inline bool Validate(const char* data, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED, std::string* error = nullptr) {
+		return Validate(data, strlen(data), commentPolicy, utf8Policy, error);
+	}
+
+#if defined(AJSON_STRING_VIEW)
+	inline bool Validate(std::string_view parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED, std::string* error = nullptr) {
+		return Validate(parseBuffer.data(), parseBuffer.size(), commentPolicy, utf8Policy, error);
+	}
+#endif
+
+	/**
+	 * @brief Parse newline delimited json (JSON Lines, NDJSON) with one object or array per line on worker threads.
+	 * 'callback' is called on the calling thread with the records in input order and takes ownership of them.
+	 * Blank lines are skipped. A 'threads' count of 0 uses all hardware threads.
+	 * Throws the error of the first invalid record prefixed with its line number, after delivering the records before it.
+	 */
+	void		ParseJsonLines(const char* data, size_t length, const std::function<void(Node*)>& callback, CommentPolicy commentPolicy = IGNORE_COMMENTS, uint32_t threads = 0, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+	/**
+	 * @brief Parse newline delimited json on worker threads, returns the records in input order.
+	 */
+	std::vector<Node*> ParseJsonLines(const char* data, size_t length, CommentPolicy commentPolicy = IGNORE_COMMENTS, uint32_t threads = 0, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+	std::vector<Node*> ParseJsonLines(const std::string& parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, uint32_t threads = 0, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+	inline std::vector<Node*> ParseJsonLines(const char* data, CommentPolicy commentPolicy = IGNORE_COMMENTS, uint32_t threads = 0, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+		return ParseJsonLines(data, strlen(data), commentPolicy, threads, utf8Policy);
+	}
+
+#if defined(AJSON_STRING_VIEW)
+	inline std::vector<Node*> ParseJsonLines(std::string_view parseBuffer, CommentPolicy commentPolicy = IGNORE_COMMENTS, uint32_t threads = 0, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+		return ParseJsonLines(parseBuffer.data(), parseBuffer.size(), commentPolicy, threads, utf8Policy);
+	}
+#endif
+
+	/**
+	 * @brief Parse newline delimited json file on worker threads.
 	 * Throws exception if it can't open specified file for reading.
 	 */
-	Node*	 	ParseJsonFile(const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+	void		ParseJsonLinesFile(const std::string& filename, const std::function<void(Node*)>& callback, CommentPolicy commentPolicy = IGNORE_COMMENTS, uint32_t threads = 0, FileLoad fileLoad = LOAD_MAPPED, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+	std::vector<Node*> ParseJsonLinesFile(const std::string& filename, CommentPolicy commentPolicy = IGNORE_COMMENTS, uint32_t threads = 0, FileLoad fileLoad = LOAD_MAPPED, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+
+	/**
+	 * @brief Parses json that arrives in chunks, e.g. from a socket or a chunked upload.
+	 * Chunks can be split anywhere, also inside strings, numbers or comments. Each Feed() parses all tokens
+	 * completed so far, only the unfinished tail of the input is kept, so memory stays bounded by the
+	 * largest token rather than the document.
+	 * After Feed() or Finish() throws the parser can't be used anymore, a target document is left empty.
+	 *
+	 * @code
+	 * PushParser parser;
+	 * while((received = recv(socket, buffer, sizeof(buffer), 0)) > 0) {
+	 * 	parser.Feed(buffer, received);
+	 * }
+	 * Node* rootNode = parser.Finish();
+	 * @endcode
+	 */
+	class PushParser
+	{
+	public:
+		/**
+		 * @brief Builds heap allocated nodes, the root node is returned by Finish().
+		 */
+		explicit PushParser(CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+		/**
+		 * @brief Resets document and builds the nodes into it.
+		 */
+		explicit PushParser(Document& document, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+		/**
+		 * @brief Reports events to handler as soon as their tokens are complete, no nodes are created.
+		 */
+		explicit PushParser(JsonHandler& handler, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED);
+		~PushParser();
+
+		/**
+		 * @brief Parses the next 'length' bytes of input. The chunk isn't referenced after returning.
+		 */
+		void		Feed(const char* data, size_t length);
+		/**
+		 * @brief Parses the rest of the input and checks the document is complete.
+		 * Returns the root node, which the caller owns unless it was built into a Document.
+		 * Returns nullptr for empty input or when reporting to a handler.
+		 */
+		Node*		Finish();
+
+		class State;
+	private:
+		PushParser(const PushParser&) = delete;
+		PushParser& operator=(const PushParser&) = delete;
+
+		void		Close();
+
+		State*		m_state;
+	};
+
+	class LazyDocument;
+	class JsonToken;
+
+	/**
+	 * @brief Read-only view of a value in a LazyDocument. Values are decoded from the json text when a getter is called.
+	 * Navigating to a missing member or index gives an invalid value, getters of invalid values return the same
+	 * defaults as Node's getters on a type mismatch.
+	 * Every navigation step scans the members of one container. Nested containers are jumped over with a binary search
+	 * over the container positions recorded on load, O(log n) in the number of containers instead of scanning them.
+	 */
+	class LazyValue
+	{
+	public:
+		LazyValue() : m_document(nullptr), m_location(0), m_nameLocation(0) {}
+
+		/**
+		 * @brief False if navigation didn't find the value.
+		 */
+		inline bool IsValid() const {
+			return m_document != nullptr;
+		}
+
+		/**
+		 * @brief Returns NULL_T for invalid values.
+		 */
+		enum NodeType GetType() const;
+		/**
+		 * @brief Name of object members, empty for array elements and the root.
+		 */
+		std::string	GetName() const;
+
+		/**
+		 * @brief Number of members or elements, 0 for other types. Counting scans the whole container.
+		 */
+		uint32_t	Children() const;
+		LazyValue	GetChild(uint32_t n) const;
+		/**
+		 * @brief Member named 'name', the last one if there are duplicates.
+		 */
+		LazyValue	GetChild(const std::string& name) const;
+
+		inline LazyValue operator[](uint32_t n) const {
+			return GetChild(n);
+		}
+		inline LazyValue operator[](const std::string& name) const {
+			return GetChild(name);
+		}
+
+		/**
+		 * @brief Use FirstChild() and NextSibling() to visit all children in one scan.
+		 */
+		LazyValue	FirstChild() const;
+		LazyValue	NextSibling() const;
+
+		int32_t		GetInt() const;
+		int64_t		GetInt64() const;
+		float		GetFloat() const;
+		double		GetDouble() const;
+		bool		GetBool() const;
+		std::string	GetString() const;
+		std::vector<uint8_t> GetBlob() const;
+
+		/**
+		 * @brief Builds a heap allocated Node (sub)tree of the value, nullptr for invalid values.
+		 */
+		Node*		Materialize() const;
+	private:
+		friend class LazyDocument;
+
+		LazyValue(const LazyDocument* document, uint32_t location, uint32_t nameLocation) : m_document(document), m_location(location), m_nameLocation(nameLocation) {}
+
+		const LazyDocument*	m_document;
+		uint32_t			m_location;
+		uint32_t			m_nameLocation;
+	};
+
+	/**
+	 * @brief Json that is only validated up front, values are decoded when they are navigated to.
+	 * Much cheaper than building nodes when a few values are read out of a large document.
+	 * The json buffer is referenced, not copied, and has to outlive the document and its values.
+	 * Throws PARSER_ERROR on invalid json like ParseJson().
+	 *
+	 * @code
+	 * LazyDocument doc(request.data(), request.size());
+	 * int64_t id = doc["user"]["id"].GetInt64();
+	 * @endcode
+	 */
+	class LazyDocument
+	{
+	public:
+		LazyDocument(const char* data, size_t length, CommentPolicy commentPolicy = IGNORE_COMMENTS);
+		LazyDocument(const char* json, CommentPolicy commentPolicy = IGNORE_COMMENTS) : LazyDocument(json, strlen(json), commentPolicy) {}
+		LazyDocument(const std::string& json, CommentPolicy commentPolicy = IGNORE_COMMENTS) : LazyDocument(json.data(), json.size(), commentPolicy) {}
+		/**
+		 * @brief The buffer has to outlive the document.
+		 */
+		LazyDocument(std::string&& json, CommentPolicy commentPolicy = IGNORE_COMMENTS) = delete;
+#if defined(AJSON_STRING_VIEW)
+		LazyDocument(std::string_view json, CommentPolicy commentPolicy = IGNORE_COMMENTS) : LazyDocument(json.data(), json.size(), commentPolicy) {}
+#endif
+
+		/**
+		 * @brief Invalid value for empty input.
+		 */
+		LazyValue	GetRoot() const;
+
+		inline LazyValue operator[](uint32_t n) const {
+			return GetRoot().GetChild(n);
+		}
+		inline LazyValue operator[](const std::string& name) const {
+			return GetRoot().GetChild(name);
+		}
+	private:
+		friend class LazyValue;
+
+		LazyDocument(const LazyDocument&) = delete;
+		LazyDocument& operator=(const LazyDocument&) = delete;
+
+		/**
+		 * @brief Where a container begins and ends in the json text.
+		 */
+		struct Span
+		{
+			uint32_t	begin;
+			uint32_t	end;
+		};
+
+		static const uint32_t NoLocation = UINT32_MAX;
+
+		bool		Next(uint32_t& location, JsonToken& token) const;
+		uint32_t	Skip(uint32_t location) const;
+		bool		Step(uint32_t& location, bool object, JsonToken& name, JsonToken& value) const;
+
+		const char*			m_data;
+		uint32_t			m_length;
+		uint32_t			m_root;
+		CommentPolicy		m_commentPolicy;
+		std::vector<Span>	m_spans;
+	};
 };
 
 #endif //ajson.hpp
@@ -0,0 +1,31 @@
+#ifndef AJSON_INTERNAL_HPP
+#define AJSON_INTERNAL_HPP
+
+#include "ajson.hpp"
+
+/**
+ * Parser internals that are not part of the public API, declared for the tests.
+ */
+namespace ajson {
+	/**
+	 * @brief Finds the ',' that split a root array into up to 'parts' ranges for PARSE_PARALLEL
+	 * @param parseBuffer The json input
+	 * @param length Length of the input
+	 * @param parts Maximum number of ranges
+	 * @return Offsets of the separating ',', empty if the input isn't split
+	 */
+	std::vector<uint32_t> FindArraySplits(const char* parseBuffer, uint32_t length, uint32_t parts);
+
+	/**
+	 * @brief Parses a root array with PARSE_PARALLEL on a fixed number of threads
+	 * @param parseBuffer The json input
+	 * @param length Length of the input
+	 * @param commentPolicy How comments are handled
+	 * @param utf8Policy Whether strings are validated as UTF-8
+	 * @param threads Number of threads, the input is parsed on one if it can't be split
+	 * @return The heap allocated root node
+	 */
+	Node* ParseJsonParallel(const char* parseBuffer, uint32_t length, CommentPolicy commentPolicy, Utf8Policy utf8Policy, uint32_t threads);
+};
+
+#endif //ajson_internal.hpp
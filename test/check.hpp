@@ -0,0 +1,32 @@
+#ifndef AJSON_CHECK_HPP
+#define AJSON_CHECK_HPP
+
+#include <iostream>
+
+/**
+ * Minimal checks shared by the tests, a failed CHECK is reported and counted without stopping the test.
+ */
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if(!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+			failures++; \
+		} \
+	} while(0)
+
+/**
+ * Reports the result of the test named 'name', returns the exit code for main().
+ */
+static int TestResult(const char* name) {
+	if(failures > 0) {
+		std::cerr << name << ": " << failures << " failures" << std::endl;
+		return 1;
+	}
+
+	std::cout << name << " passed" << std::endl;
+	return 0;
+}
+
+#endif //check.hpp
@@ -0,0 +1,138 @@
+/**
+ * Names shared through a Document's key table: rename, comment and move must never touch
+ * the interned text of other nodes or the table itself.
+ *
+ * g++ -std=c++11 -pthread -Isrc src/ajson.cpp test/intern_test.cpp -o intern_test
+ */
+#include "ajson.hpp"
+
+#include "check.hpp"
+
+using namespace ajson;
+
+static const char* LongKey = "a_fairly_long_key_name_xx";
+static const char* SharedJson = "{\"a_fairly_long_key_name_xx\":1,\"o\":{\"a_fairly_long_key_name_xx\":2}}";
+
+static void TestCommentOnInternedName() {
+	Document document;
+	Node* root = document.Parse(SharedJson);
+
+	// Shorter than the interned key, so it would fit in the shared buffer
+	root->GetChild(0u)->SetComment("short text comment!!");
+	CHECK(root->GetChild(0u)->GetComment() == "short text comment!!");
+
+	Node* object = root->GetChild("o");
+	CHECK(object->GetChild(0u)->GetName() == LongKey);
+	CHECK(object->GetChild(LongKey) != nullptr && object->GetChild(LongKey)->GetInt() == 2);
+
+	// The key table still hands out the original text
+	Node* added = object->CreateInt(3, LongKey);
+	CHECK(added->GetName() == LongKey);
+}
+
+static void TestRenameInternedName() {
+	Document document;
+	Node* root = document.Parse(SharedJson);
+
+	Node* first = root->GetChild(LongKey);
+	first->SetName("another_long_key_name_abc");
+	CHECK(first->GetName() == "another_long_key_name_abc");
+	CHECK(root->GetChild("another_long_key_name_abc") == first);
+	CHECK(root->GetChild(LongKey) == nullptr);
+
+	first->SetName("short");
+	CHECK(root->GetChild("short") == first);
+	CHECK(root->GetChild("o")->GetChild(LongKey)->GetInt() == 2);
+}
+
+static void TestRenameWithKeyIndex() {
+	std::string json = "{";
+	for(uint32_t i = 0;i < Node::KeyIndexThreshold * 2;i++) {
+		json += (i > 0 ? ",\"" : "\"") + std::string("long_indexed_key_number_") + std::to_string(i) + "\":" + std::to_string(i);
+	}
+	json += "}";
+
+	Document document;
+	Node* root = document.Parse(json);
+
+	Node* third = root->GetChild("long_indexed_key_number_3");
+	CHECK(third != nullptr && third->GetInt() == 3);
+
+	third->SetName("long_indexed_key_renamed");
+	CHECK(root->GetChild("long_indexed_key_renamed") == third);
+	CHECK(root->GetChild("long_indexed_key_number_3") == nullptr);
+
+	// Moving over a child replaces its name too
+	Node other(INT_T, "renamed");
+	other.SetInt(42);
+	*root->GetChild("long_indexed_key_number_6") = std::move(other);
+	CHECK(root->GetChild("renamed") != nullptr && root->GetChild("renamed")->GetInt() == 42);
+	CHECK(root->GetChild("long_indexed_key_number_6") == nullptr);
+
+	Node* moved = root->GetChild("long_indexed_key_number_7");
+	*moved = std::move(*root->GetChild("long_indexed_key_number_2"));
+	CHECK(root->GetChild("long_indexed_key_number_7") == nullptr);
+	CHECK(root->GetChild("long_indexed_key_number_2") == moved);
+
+	root->GetChild("long_indexed_key_number_4")->SetComment("was four");
+	CHECK(root->GetChild("long_indexed_key_number_4") == nullptr);
+	CHECK(root->GetChild("long_indexed_key_number_5")->GetInt() == 5);
+
+	// Removing the last of duplicate names finds the one before it again
+	Node* first = root->CreateInt(1, "duplicate");
+	root->CreateInt(2, "duplicate");
+	root->RemoveChild(root->Children() - 1);
+	CHECK(root->GetChild("duplicate") == first);
+
+	// Inserted in front, so it's only found once the later one is gone
+	Node front(INT_T, "duplicate");
+	front.SetInt(0);
+	Node* inserted = root->AddChild(&front, 0);
+	CHECK(root->GetChild("duplicate") == first);
+	root->RemoveChild(first);
+	CHECK(root->GetChild("duplicate") == inserted && inserted->GetInt() == 0);
+
+	// Lookups through a const tree
+	const Node* constRoot = root;
+	CHECK(constRoot->GetChild("long_indexed_key_number_9")->GetInt() == 9);
+}
+
+static void TestMoveInternedName() {
+	Document document;
+	Node* root = document.Parse(SharedJson);
+
+	// From the heap into the document, the name gets interned
+	Node heap(STRING_T, "heap_node_with_a_long_name");
+	heap.SetString("value");
+	*root->GetChild("o")->GetChild(LongKey) = std::move(heap);
+	CHECK(root->GetChild("o")->GetChild(0u)->GetName() == "heap_node_with_a_long_name");
+	CHECK(root->GetChild(LongKey)->GetInt() == 1);
+
+	// Within the document the shared name is taken over
+	Node* object = root->GetChild("o");
+	Node* first = root->GetChild(LongKey);
+	*object->GetChild(0u) = std::move(*first);
+	CHECK(object->GetChild(0u)->GetName() == LongKey);
+	CHECK(object->GetChild(LongKey)->GetInt() == 1);
+
+	// And from the document out to the heap
+	Node copy(NULL_T);
+	copy = std::move(*object->GetChild(0u));
+	CHECK(copy.GetName() == LongKey);
+	CHECK(copy.GetInt() == 1);
+
+	Document other;
+	Node* otherRoot = other.Parse(SharedJson);
+	*otherRoot->GetChild(LongKey) = std::move(copy);
+	CHECK(otherRoot->GetChild(LongKey)->GetInt() == 1);
+	CHECK(otherRoot->GetChild("o")->GetChild(LongKey)->GetInt() == 2);
+}
+
+int main() {
+	TestCommentOnInternedName();
+	TestRenameInternedName();
+	TestRenameWithKeyIndex();
+	TestMoveInternedName();
+
+	return TestResult("intern_test");
+}
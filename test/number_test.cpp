@@ -0,0 +1,87 @@
+/**
+ * Numbers beyond the range of double are rejected by every parse path instead of becoming infinities,
+ * and generated json never contains infinities or NaN.
+ *
+ * g++ -std=c++11 -pthread -Isrc src/ajson.cpp test/number_test.cpp -o number_test
+ */
+#include "ajson.hpp"
+
+#include "check.hpp"
+
+#include <cfloat>
+#include <limits>
+
+using namespace ajson;
+
+static std::string Parse(const std::string& json, ParseMode parseMode) {
+	try {
+		Node* root = ParseJson(json, IGNORE_COMMENTS, parseMode);
+		std::string result = GenerateJson<JSON_COMPACT>(*root);
+		delete root;
+		return result;
+	} catch(Exception& e) {
+		return std::string("error: ") + e.what();
+	}
+}
+
+static void TestOutOfRange() {
+	const ParseMode modes[] = { PARSE_SINGLE_PASS, PARSE_TOKENIZED, PARSE_PARALLEL };
+	const char* overflows[] = { "[1e400]", "[-1e400]", "[1.8e308]", "[1e100000000]", "[123456789012345678901234567890e300]" };
+	for(size_t m = 0;m < sizeof(modes) / sizeof(modes[0]);m++) {
+		for(size_t i = 0;i < sizeof(overflows) / sizeof(overflows[0]);i++) {
+			std::string result = Parse(overflows[i], modes[m]);
+			CHECK(result.compare(0, 21, "error: At line [1:2]:") == 0);
+		}
+
+		// Underflow rounds to zero, the largest double and big integers are kept
+		Node* root = ParseJson("[1e-400,-1e-400,1.7976931348623157e308,123456789012345678901234567890]", IGNORE_COMMENTS, modes[m]);
+		CHECK(root->GetChild(0u)->GetDouble() == 0.0);
+		CHECK(root->GetChild(1u)->GetDouble() == 0.0);
+		CHECK(root->GetChild(2u)->GetDouble() == DBL_MAX);
+		CHECK(root->GetChild(3u)->GetDouble() == 123456789012345678901234567890.0);
+		delete root;
+	}
+
+	PushParser parser;
+	parser.Feed("[1,", 3);
+	bool threw = false;
+	try {
+		parser.Feed("\n1e999]", 7);
+		parser.Finish();
+	} catch(Exception& e) {
+		threw = e.what().compare(0, 15, "At line [2:1]: ") == 0;
+	}
+	CHECK(threw);
+}
+
+static void TestNonFinite() {
+	const double infinity = std::numeric_limits<double>::infinity();
+	Node root(OBJECT_T);
+	root.CreateDouble(infinity, "inf");
+	root.CreateDouble(-infinity, "minus");
+	root.CreateDouble(std::numeric_limits<double>::quiet_NaN(), "nan");
+	Node* values = root.CreateArray("values");
+	values->AppendDouble(1.5);
+	values->AppendDouble(-infinity);
+	values->AppendDouble(std::numeric_limits<double>::quiet_NaN());
+
+	std::string json = GenerateJson<JSON_COMPACT>(root);
+	CHECK(json == "{\"inf\":null,\"minus\":null,\"nan\":null,\"values\":[1.5,null,null]}");
+
+	// The output parses back and generates the same json
+	Node* parsed = ParseJson(json);
+	CHECK(parsed->GetChild("inf")->IsNull());
+	CHECK(GenerateJson<JSON_COMPACT>(*parsed) == json);
+	delete parsed;
+
+	parsed = ParseJson(GenerateJson<JSON_SPACED>(root));
+	CHECK(GenerateJson<JSON_COMPACT>(*parsed) == json);
+	delete parsed;
+}
+
+int main() {
+	TestOutOfRange();
+	TestNonFinite();
+
+	return TestResult("number_test");
+}
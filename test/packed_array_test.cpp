@@ -0,0 +1,189 @@
+/**
+ * Documents that pack arrays store arrays of only ints, floats or booleans in one buffer on every parse path.
+ * Reading never converts a packed array, only Unpack() and mutations do.
+ *
+ * g++ -std=c++11 -pthread -Isrc src/ajson.cpp test/packed_array_test.cpp -o packed_array_test
+ */
+#include "ajson.hpp"
+
+#include "check.hpp"
+
+using namespace ajson;
+
+static const char* Json = "{\"i\":[1,2,-3],\"f\":[0.5,1.5],\"b\":[true,false,true],\"m\":[1,2.5],\"s\":[1,\"x\"],"
+	"\"e\":[],\"n\":[[1,2],[3.5]],\"c\":[1,/*c*/2]}";
+static const char* Compact = "{\"i\":[1,2,-3],\"f\":[0.5,1.5],\"b\":[true,false,true],\"m\":[1,2.5],\"s\":[1,\"x\"],"
+	"\"e\":[],\"n\":[[1,2],[3.5]],\"c\":[1,2]}";
+
+static void CheckPacked(Node* root, bool commentsKept) {
+	CHECK(GenerateJson<JSON_COMPACT>(*root) == Compact);
+
+	Node* ints = root->GetChild("i");
+	CHECK(ints->GetPackedType() == INT_T);
+	CHECK(ints->Children() == 3);
+	CHECK(ints->GetPackedInts() != nullptr && ints->GetPackedInts()[2] == -3);
+	CHECK(ints->GetPackedDoubles() == nullptr && ints->GetPackedBools() == nullptr);
+
+	Node* floats = root->GetChild("f");
+	CHECK(floats->GetPackedType() == FLOAT_T && floats->GetPackedDoubles()[1] == 1.5);
+
+	Node* bools = root->GetChild("b");
+	CHECK(bools->GetPackedType() == BOOL_T && !bools->GetPackedBools()[1]);
+
+	// Mixed, empty and string arrays keep child nodes
+	Node* mixed = root->GetChild("m");
+	CHECK(!mixed->IsPacked() && mixed->GetChild(0u)->IsInt() && mixed->GetChild(1u)->IsFloat());
+	CHECK(!root->GetChild("s")->IsPacked() && !root->GetChild("e")->IsPacked());
+
+	Node* nested = root->GetChild("n");
+	CHECK(!nested->IsPacked());
+	CHECK(nested->GetChild(0u)->GetPackedType() == INT_T && nested->GetChild(1u)->GetPackedType() == FLOAT_T);
+
+	// A kept comment is a child node, so its array can't be packed
+	CHECK(root->GetChild("c")->IsPacked() != commentsKept);
+
+	CHECK(root->GetChild("x") == nullptr);
+	CHECK(!root->IsPacked() && root->GetPackedInts() == nullptr);
+}
+
+static void CheckNodes(Node* root) {
+	CHECK(GenerateJson<JSON_COMPACT>(*root) == Compact);
+	CHECK(!root->GetChild("i")->IsPacked() && root->GetChild("i")->GetChild(2u)->GetInt() == -3);
+	CHECK(!root->GetChild("f")->IsPacked() && !root->GetChild("n")->GetChild(0u)->IsPacked());
+}
+
+static void TestParsePaths() {
+	const ParseMode modes[] = { PARSE_SINGLE_PASS, PARSE_TOKENIZED, PARSE_PARALLEL };
+	for(size_t i = 0;i < sizeof(modes) / sizeof(modes[0]);i++) {
+		// Packing is off unless a document asks for it
+		Node* root = ParseJson(Json, ACCEPT_COMMENTS, modes[i]);
+		CheckNodes(root);
+		delete root;
+
+		Document document;
+		CheckNodes(document.Parse(Json, ACCEPT_COMMENTS, modes[i]));
+		document.SetPackArrays(true);
+		CheckPacked(document.Parse(Json, ACCEPT_COMMENTS, modes[i]), true);
+	}
+
+	Document document;
+	document.SetPackArrays(true);
+	PushParser parser(document, ACCEPT_COMMENTS);
+	parser.Feed(Json, 20);
+	parser.Feed(Json + 20, strlen(Json) - 20);
+	CheckPacked(parser.Finish(), true);
+
+	// Binary output writes packed elements, reading it back gives heap nodes
+	BinaryBuffer* binary = GenerateBinary(*document.Parse(Json));
+	Node* decoded = ParseBinary(*binary);
+	CheckNodes(decoded);
+	delete decoded;
+	delete binary;
+
+	// Projection packs the arrays it keeps
+	std::vector<std::string> paths;
+	paths.push_back("/i");
+	paths.push_back("n.*");
+	Node* projected = document.Parse(Json, paths);
+	CHECK(GenerateJson<JSON_COMPACT>(*projected) == "{\"i\":[1,2,-3],\"n\":[[1,2],[3.5]]}");
+	CHECK(projected->GetChild("i")->GetPackedType() == INT_T);
+	CHECK(projected->GetChild("n")->GetChild(1u)->GetPackedType() == FLOAT_T);
+}
+
+static void TestUnpack() {
+	Document document;
+	document.SetPackArrays(true);
+	Node* root = document.Parse(Json);
+
+	// Appending the same type stays packed, another type unpacks
+	Node* ints = root->GetChild("i");
+	ints->AppendInt64(4);
+	CHECK(ints->IsPacked() && ints->Children() == 4);
+	ints->AppendDouble(4.5);
+	CHECK(!ints->IsPacked() && ints->Children() == 5);
+	CHECK(ints->GetChild(3u)->GetInt() == 4 && ints->GetChild(4u)->GetDouble() == 4.5);
+
+	// Reading never converts, elements have no nodes until Unpack()
+	const Node* floats = root->GetChild("f");
+	CHECK(floats->GetChild(0u) == nullptr && floats->GetFirstChild() == nullptr && floats->GetLastChild() == nullptr);
+	CHECK(floats->begin() == floats->end() && floats->IsPacked());
+	root->GetChild("f")->Unpack();
+	CHECK(!floats->IsPacked() && floats->GetChild(0u)->GetDouble() == 0.5);
+	CHECK(floats->GetChild(0u)->GetParent() == floats);
+
+	Node* bools = root->GetChild("b");
+	bools->Unpack();
+	uint32_t count = 0;
+	for(Node* child : *bools) {
+		CHECK(child->IsBool());
+		count++;
+	}
+	CHECK(count == 3);
+
+	// Mutation unpacks
+	Node* pair = root->GetChild("n")->GetChild(1u);
+	pair->CreateString("z");
+	CHECK(GenerateJson<JSON_COMPACT>(*pair) == "[3.5,\"z\"]");
+
+	Node* empty = root->GetChild("e");
+	empty->AppendBool(true);
+	empty->AppendBool(false);
+	CHECK(empty->GetPackedType() == BOOL_T);
+	empty->RemoveChild(0u);
+	CHECK(!empty->IsPacked() && empty->Children() == 1 && !empty->GetChild(0u)->GetBool());
+
+	// Changing the type of a packed array releases the elements
+	Node* changed = root->CreateArray("changed");
+	changed->AppendDouble(1.0);
+	changed->SetInt(3);
+	CHECK(changed->GetInt() == 3 && !changed->IsPacked());
+
+	// An emptied array starts packing again
+	Node* reused = root->CreateArray("reused");
+	reused->AppendDouble(1.0);
+	reused->AppendDouble(2.0);
+	reused->RemoveAllChildren();
+	CHECK(!reused->IsPacked() && reused->Children() == 0);
+	reused->AppendInt64(7);
+	CHECK(reused->GetPackedType() == INT_T);
+
+	// Moving keeps a packed array packed inside one document, other owners get nodes
+	Node moved(std::move(*reused));
+	CHECK(moved.GetPackedType() == INT_T && moved.Children() == 1);
+	CHECK(!reused->IsPacked() && reused->Children() == 0);
+
+	Node heap(NULL_T);
+	heap = std::move(*root->GetChild("i"));
+	CHECK(!heap.IsPacked() && heap.Children() == 5);
+
+	bool threw = false;
+	try {
+		root->AppendInt64(1);
+	} catch(Exception&) {
+		threw = true;
+	}
+	CHECK(threw);
+}
+
+static void TestHeapAppend() {
+	// Without a packing document the Append functions add nodes
+	Node heap(ARRAY_T);
+	heap.AppendInt64(5);
+	heap.AppendDouble(6.5);
+	heap.AppendBool(true);
+	CHECK(!heap.IsPacked() && heap.Children() == 3);
+	CHECK(heap.GetChild(0u)->GetInt() == 5 && heap.GetChild(1u)->GetDouble() == 6.5 && heap.GetChild(2u)->GetBool());
+
+	Document document;
+	Node* root = document.Parse("{\"a\":[]}");
+	root->GetChild("a")->AppendInt64(1);
+	CHECK(!root->GetChild("a")->IsPacked() && root->GetChild("a")->GetChild(0u)->GetInt() == 1);
+}
+
+int main() {
+	TestParsePaths();
+	TestUnpack();
+	TestHeapAppend();
+
+	return TestResult("packed_array_test");
+}
@@ -0,0 +1,125 @@
+/**
+ * PARSE_PARALLEL must give the same tree, or the same error, as PARSE_SINGLE_PASS wherever the root array
+ * gets split. Runs the array parser with a fixed thread count, so inputs are split independent of the
+ * hardware threads of the machine running the test.
+ *
+ * g++ -std=c++11 -pthread -Isrc src/ajson.cpp test/parallel_parse_test.cpp -o parallel_parse_test
+ */
+#include "ajson_internal.hpp"
+
+#include "check.hpp"
+
+using namespace ajson;
+
+static const int Records = 60000;
+static const uint32_t Threads = 6;
+
+/**
+ * Root array whose elements contain structural characters inside strings, so a split on them would be wrong.
+ */
+static std::string MakeArray(const std::string& separator = ",") {
+	std::string json = "[\n";
+	for(int i = 0;i < Records;i++) {
+		if(i > 0) {
+			json += separator;
+		}
+		json += "{\"id\":" + std::to_string(i) + ",\"text\":\"a, [b] {c} \\\"d\\\", e\\\\\",\"values\":[" + std::to_string(i) + ",0.5,true],";
+		json += "\"nested\":[[],{},[{\"x\":null}]],\"name\":\"record number " + std::to_string(i) + "\"}";
+	}
+	json += "\n]";
+	return json;
+}
+
+static std::string Parse(const std::string& json, ParseMode parseMode, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+	try {
+		Node* root;
+		if(parseMode == PARSE_PARALLEL) {
+			root = ParseJsonParallel(json.data(), static_cast<uint32_t>(json.size()), commentPolicy, utf8Policy, Threads);
+		} else {
+			root = ParseJson(json, commentPolicy, parseMode, utf8Policy);
+		}
+		std::string result = GenerateJson<JSON_COMPACT>(*root, commentPolicy);
+		delete root;
+		return result;
+	} catch(Exception& e) {
+		return std::string("error: ") + e.what();
+	}
+}
+
+static void CheckSame(const std::string& json, CommentPolicy commentPolicy = IGNORE_COMMENTS, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+	std::string expected = Parse(json, PARSE_SINGLE_PASS, commentPolicy, utf8Policy);
+	std::string result = Parse(json, PARSE_PARALLEL, commentPolicy, utf8Policy);
+	CHECK(result == expected);
+	if(result != expected) {
+		std::cerr << "  expected " << expected.substr(0, 200) << std::endl;
+		std::cerr << "  got      " << result.substr(0, 200) << std::endl;
+	}
+}
+
+static void TestSameTree() {
+	std::string json = MakeArray();
+	CHECK(FindArraySplits(json.data(), static_cast<uint32_t>(json.size()), Threads).size() == Threads - 1);
+	CheckSame(json);
+
+	Node* root = ParseJsonParallel(json.data(), static_cast<uint32_t>(json.size()), IGNORE_COMMENTS, UTF8_UNCHECKED, Threads);
+	CHECK(root->Children() == static_cast<uint32_t>(Records));
+	CHECK(root->GetChild(static_cast<uint32_t>(Records - 1))->GetChild("id")->GetInt() == Records - 1);
+	for(uint32_t i = 0;i < root->Children();i += 997) {
+		CHECK(root->GetChild(i)->GetParent() == root);
+	}
+	delete root;
+
+	// Whitespace around the separators
+	CheckSame(MakeArray(" ,\n\t"));
+
+	// Non-array roots and Document parsing fall back to one thread
+	std::string object = "{\"array\":" + json + "}";
+	CHECK(FindArraySplits(object.data(), static_cast<uint32_t>(object.size()), Threads).empty());
+	CheckSame(object);
+
+	Document document;
+	Node* documentRoot = document.Parse(json, IGNORE_COMMENTS, PARSE_PARALLEL);
+	CHECK(documentRoot->Children() == static_cast<uint32_t>(Records));
+}
+
+static void TestComments() {
+	// The split scan stops at the first comment, so put some ranges before it
+	std::string json = MakeArray();
+	json.insert(json.find("{\"id\":" + std::to_string(Records / 2)), "/* between, [elements] */ ");
+	CHECK(!FindArraySplits(json.data(), static_cast<uint32_t>(json.size()), Threads).empty());
+	CheckSame(json, ACCEPT_COMMENTS);
+	CheckSame(json, IGNORE_COMMENTS);
+	CheckSame(json, NO_COMMENTS);
+}
+
+static void TestErrors() {
+	std::string json = MakeArray();
+
+	// Errors in the first, a middle and the last range report the same message as one thread
+	const size_t positions[] = { json.find("\"values\":[", json.size() / 10), json.find("\"values\":[", json.size() / 2), json.rfind("\"values\":[") };
+	for(size_t i = 0;i < sizeof(positions) / sizeof(positions[0]);i++) {
+		std::string broken = json;
+		broken[positions[i] + 9] = '{';
+		CheckSame(broken);
+		CHECK(Parse(broken, PARSE_PARALLEL).compare(0, 7, "error: ") == 0);
+	}
+
+	// Missing closing bracket and trailing garbage
+	CheckSame(json.substr(0, json.size() - 1));
+	CheckSame(json + " x");
+
+	// Invalid UTF-8 in a late range
+	std::string invalid = json;
+	invalid.insert(invalid.rfind("record number"), "\xc3(");
+	CheckSame(invalid, IGNORE_COMMENTS, UTF8_VALIDATE);
+	CHECK(Parse(invalid, PARSE_PARALLEL, IGNORE_COMMENTS, UTF8_VALIDATE).compare(0, 7, "error: ") == 0);
+	CheckSame(invalid, IGNORE_COMMENTS, UTF8_UNCHECKED);
+}
+
+int main() {
+	TestSameTree();
+	TestComments();
+	TestErrors();
+
+	return TestResult("parallel_parse_test");
+}
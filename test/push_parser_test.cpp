@@ -0,0 +1,192 @@
+/**
+ * PushParser must build the same tree as ParseJson() wherever the input is split into chunks.
+ *
+ * g++ -std=c++11 -pthread -Isrc src/ajson.cpp test/push_parser_test.cpp -o push_parser_test
+ */
+#include "ajson.hpp"
+
+#include "check.hpp"
+
+using namespace ajson;
+
+static const char* Documents[] = {
+	"{\"name\":\"value\",\"n\":-12.5e3,\"list\":[1,2,3,true,false,null],\"nested\":{\"a\":{\"b\":[]}}}",
+	"[\"esc\\\"aped \\\\ \\u00e9\\ud83d\\ude00\", \"\xc3\xa9t\xc3\xa9\", 12345678901234, -0.5]",
+	"  {\n\t\"spaced\" :\r\n [ 1 , 2 ] ,\"empty\":\"\" }  \n",
+	"/* leading */ {\"a\":1, /* inside * star **/ \"b\":[/**/2]}",
+	"[[[[]]],{},[{\"\":0}]]",
+};
+
+static std::string Generate(Node* root) {
+	return root != nullptr ? GenerateJson<JSON_COMPACT>(*root, ACCEPT_COMMENTS) : std::string("<null>");
+}
+
+static std::string PushChunks(const std::string& json, const std::vector<size_t>& splits, CommentPolicy commentPolicy, Utf8Policy utf8Policy = UTF8_UNCHECKED) {
+	PushParser parser(commentPolicy, utf8Policy);
+	size_t start = 0;
+	for(size_t i = 0;i <= splits.size();i++) {
+		size_t end = i < splits.size() ? splits[i] : json.size();
+		parser.Feed(json.data() + start, end - start);
+		start = end;
+	}
+
+	Node* root = parser.Finish();
+	std::string result = Generate(root);
+	delete root;
+	return result;
+}
+
+static void TestEverySplit() {
+	for(size_t d = 0;d < sizeof(Documents) / sizeof(Documents[0]);d++) {
+		std::string json = Documents[d];
+		Node* expectedRoot = ParseJson(json, ACCEPT_COMMENTS);
+		std::string expected = Generate(expectedRoot);
+		delete expectedRoot;
+
+		// One split at every position, including empty first and last chunks
+		for(size_t split = 0;split <= json.size();split++) {
+			std::string result = PushChunks(json, std::vector<size_t>(1, split), ACCEPT_COMMENTS);
+			CHECK(result == expected);
+			if(result != expected) {
+				std::cerr << "  document " << d << " split at " << split << ": " << result << std::endl;
+			}
+		}
+
+		// Byte by byte
+		std::vector<size_t> splits;
+		for(size_t i = 1;i < json.size();i++) {
+			splits.push_back(i);
+		}
+		CHECK(PushChunks(json, splits, ACCEPT_COMMENTS) == expected);
+		CHECK(PushChunks(json, splits, ACCEPT_COMMENTS, UTF8_VALIDATE) == expected);
+	}
+}
+
+static void TestErrors() {
+	// Incomplete input is only detected by Finish()
+	PushParser incomplete;
+	incomplete.Feed("{\"a\":[1,", 8);
+	bool threw = false;
+	try {
+		incomplete.Finish();
+	} catch(Exception&) {
+		threw = true;
+	}
+	CHECK(threw);
+
+	// A parser that failed can't be used again
+	threw = false;
+	try {
+		incomplete.Feed("2]}", 3);
+	} catch(Exception&) {
+		threw = true;
+	}
+	CHECK(threw);
+
+	// Invalid UTF-8 split over two chunks
+	PushParser validating(IGNORE_COMMENTS, UTF8_VALIDATE);
+	threw = false;
+	try {
+		validating.Feed("[\"\xc3", 3);
+		validating.Feed("(\"]", 3);
+		validating.Finish();
+	} catch(Exception&) {
+		threw = true;
+	}
+	CHECK(threw);
+
+	// Comments are rejected with NO_COMMENTS even when split
+	PushParser noComments(NO_COMMENTS);
+	threw = false;
+	try {
+		noComments.Feed("[1,/", 4);
+		noComments.Feed("* c */2]", 8);
+		noComments.Finish();
+	} catch(Exception&) {
+		threw = true;
+	}
+	CHECK(threw);
+
+	// Errors are located in the whole input, not in the chunk that failed
+	std::string json = "[\n";
+	for(int i = 0;i < 8;i++) {
+		json += "  1,\n";
+	}
+	json += "  2, t-ue]\n";
+	std::string expected;
+	try {
+		delete ParseJson(json);
+	} catch(Exception& e) {
+		expected = e.what();
+	}
+	CHECK(expected.compare(0, 15, "At line [10:6]:") == 0);
+
+	const size_t splits[] = { 3, 30, json.find("t-ue"), json.size() - 4 };
+	for(size_t i = 0;i < sizeof(splits) / sizeof(splits[0]);i++) {
+		std::string message;
+		try {
+			PushParser parser;
+			parser.Feed(json.data(), splits[i]);
+			parser.Feed(json.data() + splits[i], json.size() - splits[i]);
+			parser.Finish();
+		} catch(Exception& e) {
+			message = e.what();
+		}
+		CHECK(message.compare(0, 15, "At line [10:6]:") == 0);
+	}
+}
+
+static void TestDocumentTarget() {
+	Document document;
+	PushParser parser(document);
+	parser.Feed("{\"a_fairly_long_key_name_xx\":[1,", 32);
+	parser.Feed("2],\"b\":\"str", 11);
+	parser.Feed("ing\"}", 5);
+	Node* root = parser.Finish();
+	CHECK(root == document.GetRoot());
+	CHECK(Generate(root) == "{\"a_fairly_long_key_name_xx\":[1,2],\"b\":\"string\"}");
+
+	// A failed parse leaves the document empty
+	Document failed;
+	PushParser failing(failed);
+	failing.Feed("{\"a\":", 5);
+	try {
+		failing.Finish();
+	} catch(Exception&) {
+	}
+	CHECK(failed.GetRoot() == nullptr);
+}
+
+class CountingHandler : public JsonHandler
+{
+public:
+	CountingHandler() : events(0), ints(0) {}
+
+	virtual void StartArray() { events++; }
+	virtual void EndArray() { events++; }
+	virtual void Int(int64_t value) { events++; ints += value; }
+
+	int		events;
+	int64_t	ints;
+};
+
+static void TestHandlerTarget() {
+	CountingHandler handler;
+	PushParser parser(handler);
+	parser.Feed("[10", 3);
+	CHECK(handler.ints == 0);
+	parser.Feed("0,2", 3);
+	CHECK(handler.ints == 100);
+	parser.Feed("3]", 2);
+	CHECK(parser.Finish() == nullptr);
+	CHECK(handler.events == 4 && handler.ints == 123);
+}
+
+int main() {
+	TestEverySplit();
+	TestErrors();
+	TestDocumentTarget();
+	TestHandlerTarget();
+
+	return TestResult("push_parser_test");
+}